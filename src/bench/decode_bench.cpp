@@ -0,0 +1,420 @@
+/**
+ * This file is part of libnntp.
+ *
+ * libnntp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnntp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "cpu_features.h"
+#include "decoder.h"
+#include "encoder.h"
+#include "crc32.h"
+#include "decoded_article.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+namespace
+{
+  /**
+   * A synthetic yEnc article
+   */
+  struct corpus
+  {
+    std::string name;       // description of the corpus
+    int         line;       // encoded line length
+    double      escapes;    // fraction of bytes that need escaping
+    double      dots;       // fraction of lines starting with a dot
+    std::string data;       // the original data
+    std::string article;    // the encoded article, headers included
+    std::size_t body;       // offset of the encoded data in the article
+    std::size_t body_end;   // offset of the =yend line in the article
+  };
+  
+  /**
+   * A kernel to measure
+   */
+  template <typename kernel> struct kernel_entry
+  {
+    const char  *name;      // name of the kernel
+    kernel      function;   // the kernel itself
+    bool        supported;  // whether the cpu can run it
+  };
+  
+  /**
+   * A single measurement
+   */
+  struct result
+  {
+    std::string benchmark;  // what was measured
+    std::string corpus;     // what it was measured on
+    std::string kernel;     // which kernel was used
+    double      throughput; // gigabytes per second
+  };
+  
+  // small and fast pseudo random number generator, so corpora are the same on every run
+  struct generator
+  {
+    uint64_t state;
+    
+    generator(uint64_t seed) : state(seed * 0x9e3779b97f4a7c15ULL + 1) {}
+    
+    uint32_t next()
+    {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      return (uint32_t) (state >> 16);
+    }
+    
+    double fraction()
+    {
+      return next() / 4294967296.0;
+    }
+  };
+  
+  // bytes that end up as a critical character (nul, lf, cr, =) after adding 42
+  const unsigned char critical[] = { 214, 224, 227, 19 };
+  
+  // encode the data the way a typical poster does
+  void encode(corpus& source, generator& random)
+  {
+    int column = 0;
+    
+    for (std::size_t i = 0; i < source.data.size(); ++i)
+    {
+      // at the start of a line, sometimes make the line begin with a dot
+      if (column == 0 && random.fraction() < source.dots)
+        source.data[i] = '.' - 42;
+      
+      unsigned char output = (unsigned char) source.data[i] + 42;
+      
+      // dot-stuffing is done by the server
+      if (column == 0 && output == '.')
+        source.article += '.';
+      
+      // escape critical characters
+      if (output == 0 || output == '\n' || output == '\r' || output == '=')
+      {
+        source.article += '=';
+        output += 64;
+        ++column;
+      }
+      
+      source.article += (char) output;
+      
+      // wrap the line
+      if (++column >= source.line)
+      {
+        source.article += "\r\n";
+        column = 0;
+      }
+    }
+    
+    if (column > 0)
+      source.article += "\r\n";
+  }
+  
+  // build an article with the requested characteristics
+  corpus make_corpus(const std::string& name, std::size_t size, int line, double escapes, double dots)
+  {
+    generator   random(size + line);
+    corpus      result;
+    char        header[256];
+    
+    result.name     = name;
+    result.line     = line;
+    result.escapes  = escapes;
+    result.dots     = dots;
+    
+    // random bytes, with the requested share of critical ones
+    result.data.resize(size);
+    
+    for (std::size_t i = 0; i < size; ++i)
+    {
+      if (escapes >= 0 && random.fraction() < escapes)
+        result.data[i] = critical[random.next() % 4];
+      else
+      {
+        do
+          result.data[i] = (char) random.next();
+        while (escapes >= 0 && memchr(critical, (unsigned char) result.data[i], sizeof(critical)) != NULL);
+      }
+    }
+    
+    // second part of a larger file
+    sprintf(header, "=ybegin part=2 total=10 line=%d size=%lu name=synthetic corpus.bin\r\n=ypart begin=%lu end=%lu\r\n",
+            line, (unsigned long) size * 10, (unsigned long) size + 1, (unsigned long) size * 2);
+    
+    result.article  = header;
+    result.body     = result.article.size() - 2;
+    
+    encode(result, random);
+    
+    result.body_end = result.article.size();
+    
+    sprintf(header, "=yend size=%lu part=2 pcrc32=%08x\r\n", (unsigned long) size, nntp::yenc::crc32(0, result.data.data(), size));
+    result.article += header;
+    
+    return result;
+  }
+  
+  // run a function until enough time has passed, returning the best throughput in gb/s
+  template <typename function> double measure(function run, std::size_t bytes)
+  {
+    typedef std::chrono::steady_clock clock;
+    
+    double best = 0;
+    
+    for (int round = 0; round < 5; ++round)
+    {
+      clock::time_point   start       = clock::now();
+      std::size_t         iterations  = 0;
+      double              elapsed;
+      
+      do
+      {
+        run();
+        ++iterations;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+      }
+      while (elapsed < 0.1);
+      
+      best = std::max(best, bytes * iterations / elapsed / 1e9);
+    }
+    
+    return best;
+  }
+  
+  // print the results as a table
+  void print_table(const std::vector<result>& results)
+  {
+    printf("%-10s %-28s %-10s %10s\n", "benchmark", "corpus", "kernel", "GB/s");
+    
+    for (std::size_t i = 0; i < results.size(); ++i)
+      printf("%-10s %-28s %-10s %10.2f\n", results[i].benchmark.c_str(), results[i].corpus.c_str(), results[i].kernel.c_str(), results[i].throughput);
+  }
+  
+  // print the results as json, one object per line
+  void print_json(const std::vector<result>& results)
+  {
+    for (std::size_t i = 0; i < results.size(); ++i)
+      printf("{\"benchmark\":\"%s\",\"corpus\":\"%s\",\"kernel\":\"%s\",\"gbps\":%.3f}\n",
+             results[i].benchmark.c_str(), results[i].corpus.c_str(), results[i].kernel.c_str(), results[i].throughput);
+  }
+}
+
+int main(int argc, const char * argv[])
+{
+  using namespace nntp;
+  
+  std::size_t         size = 768000;  // decoded size of a part
+  bool                json = false;   // print machine readable results
+  std::vector<corpus> corpora;
+  std::vector<result> results;
+  
+  // parse the arguments
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "--json") == 0)
+      json = true;
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+      size = strtoul(argv[++i], NULL, 10);
+    else
+    {
+      cerr << "usage: " << argv[0] << " [--json] [--size bytes]" << endl;
+      return 1;
+    }
+  }
+  
+  kernel_entry<yenc::decode_kernel> decoders[] = {
+    { "scalar", yenc::decode_scalar, true },
+#if defined(__x86_64__) || defined(__i386__)
+    { "sse2",   yenc::decode_sse2,   cpu().sse2 },
+    { "avx2",   yenc::decode_avx2,   cpu().avx2 },
+    { "avx512", yenc::decode_avx512, cpu().avx512bw },
+#endif
+  };
+  
+  kernel_entry<yenc::encode_kernel> encoders[] = {
+    { "scalar", yenc::encode_scalar, true },
+#if defined(__x86_64__) || defined(__i386__)
+    { "sse2",   yenc::encode_sse2,   cpu().sse2 },
+    { "avx2",   yenc::encode_avx2,   cpu().avx2 },
+    { "avx512", yenc::encode_avx512, cpu().avx512bw },
+#endif
+  };
+  
+  kernel_entry<yenc::crc_kernel> checksums[] = {
+    { "slice16", yenc::crc32_slice16, true },
+#if defined(__x86_64__) || defined(__i386__)
+    { "pclmul",  yenc::crc32_pclmul,  cpu().pclmul && cpu().sse41 },
+#endif
+  };
+  
+  // a negative escape fraction leaves the bytes fully random (about 1.6% escapes)
+  corpora.push_back(make_corpus("random/line128",           size, 128, -1,   0));
+  corpora.push_back(make_corpus("random/line256",           size, 256, -1,   0));
+  corpora.push_back(make_corpus("no-escapes/line128",       size, 128, 0,    0));
+  corpora.push_back(make_corpus("escapes-10%/line128",      size, 128, 0.1,  0));
+  corpora.push_back(make_corpus("dots-50%/line128",         size, 128, -1,   0.5));
+  corpora.push_back(make_corpus("random/line128/small-part",     size / 8, 128, -1, 0));
+  
+  std::vector<char> target(size);
+  std::vector<char> encoded(yenc::max_encoded_size(size, 128));
+  
+  for (std::size_t c = 0; c < corpora.size(); ++c)
+  {
+    const corpus& source  = corpora[c];
+    const char    *begin  = source.article.data() + source.body;
+    const char    *end    = source.article.data() + source.body_end + 2;
+    std::size_t   length  = source.body_end - source.body;
+    std::size_t   decoded = source.data.size();
+    
+    for (std::size_t k = 0; k < sizeof(decoders) / sizeof(decoders[0]); ++k)
+    {
+      if (!decoders[k].supported)
+        continue;
+      
+      yenc::decode_kernel kernel = decoders[k].function;
+      
+      // decode once to make sure the kernel is correct
+      {
+        const char          *current  = begin;
+        char                *output   = &target[0];
+        yenc::decode_state  state     = yenc::state_data;
+        
+        kernel(current, end, output, output + decoded, state);
+        
+        if (state != yenc::state_end || output != &target[0] + decoded || memcmp(&target[0], source.data.data(), decoded) != 0)
+        {
+          cerr << "kernel " << decoders[k].name << " decoded " << source.name << " incorrectly" << endl;
+          return 1;
+        }
+      }
+      
+      // decode only
+      result decode = { "decode", source.name, decoders[k].name, measure([&]() {
+        const char          *current  = begin;
+        char                *output   = &target[0];
+        yenc::decode_state  state     = yenc::state_data;
+        
+        kernel(current, end, output, output + decoded, state);
+      }, length) };
+      
+      results.push_back(decode);
+      
+      // decode and checksum in one pass
+      result fused = { "fused", source.name, decoders[k].name, measure([&]() {
+        const char          *current  = begin;
+        char                *output   = &target[0];
+        yenc::decode_state  state     = yenc::state_data;
+        uint32_t            crc       = 0;
+        
+        yenc::decode_crc(current, end, output, output + decoded, state, crc, kernel);
+      }, length) };
+      
+      results.push_back(fused);
+    }
+    
+    // the complete article, headers and footer included, with the best kernels
+    result article = { "article", source.name, "best", measure([&]() {
+      decoded_article part(source.article.data(), (int) source.article.size(), false);
+      
+      part.decode(&target[0], target.size());
+    }, length) };
+    
+    results.push_back(article);
+    
+    // encoding produces its own line breaks, so the line length of the corpus does not matter
+    for (std::size_t k = 0; k < sizeof(encoders) / sizeof(encoders[0]); ++k)
+    {
+      if (!encoders[k].supported || source.line != 128)
+        continue;
+      
+      yenc::encode_kernel kernel  = encoders[k].function;
+      const char          *data   = source.data.data();
+      
+      // make sure the kernel produces exactly what the scalar one does
+      {
+        std::vector<char>   expected(encoded.size());
+        const char          *current  = data;
+        char                *output   = &encoded[0];
+        const char          *previous = data;
+        char                *check    = &expected[0];
+        int                 column    = 0;
+        int                 reference = 0;
+        
+        kernel(current, data + decoded, output, output + encoded.size(), column, 128);
+        yenc::encode_scalar(previous, data + decoded, check, check + expected.size(), reference, 128);
+        
+        if (current != data + decoded || output - &encoded[0] != check - &expected[0] || memcmp(&encoded[0], &expected[0], output - &encoded[0]) != 0)
+        {
+          cerr << "kernel " << encoders[k].name << " encoded " << source.name << " incorrectly" << endl;
+          return 1;
+        }
+      }
+      
+      // encode and checksum in one pass, measured on the decoded size
+      result encode = { "encode", source.name, encoders[k].name, measure([&]() {
+        const char          *current  = data;
+        char                *output   = &encoded[0];
+        int                 column    = 0;
+        uint32_t            crc       = 0;
+        
+        yenc::encode_crc(current, data + decoded, output, output + encoded.size(), column, 128, crc, kernel);
+      }, decoded) };
+      
+      results.push_back(encode);
+    }
+  }
+  
+  // checksums only depend on the amount of data
+  for (std::size_t k = 0; k < sizeof(checksums) / sizeof(checksums[0]); ++k)
+  {
+    if (!checksums[k].supported)
+      continue;
+    
+    const std::string&  data    = corpora[0].data;
+    yenc::crc_kernel    kernel  = checksums[k].function;
+    
+    if (kernel(0, data.data(), data.size()) != yenc::crc32_slice16(0, data.data(), data.size()))
+    {
+      cerr << "kernel " << checksums[k].name << " computed an incorrect checksum" << endl;
+      return 1;
+    }
+    
+    result crc = { "crc32", corpora[0].name, checksums[k].name, measure([&]() {
+      volatile uint32_t value = kernel(0, data.data(), data.size());
+      (void) value;
+    }, data.size()) };
+    
+    results.push_back(crc);
+  }
+  
+  if (json)
+    print_json(results);
+  else
+    print_table(results);
+  
+  return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * This file is part of libnntp.
+ *
+ * libnntp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnntp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <thread>
+#include <chrono>
+#include <atomic>
+
+#include "mock_server.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+namespace
+{
+  // set by the signal handler
+  volatile std::sig_atomic_t  interrupted = 0;
+  
+  void interrupt(int)
+  {
+    interrupted = 1;
+  }
+}
+
+int main(int argc, const char * argv[])
+{
+  nntp::mock_settings settings;
+  
+  // parse the arguments
+  for (int i = 1; i < argc; ++i)
+  {
+    bool        has_value = i + 1 < argc;
+    const char  *value    = has_value ? argv[i + 1] : NULL;
+    
+    if (strcmp(argv[i], "--secure") == 0)
+    {
+      settings.secure = true;
+      continue;
+    }
+    else if (!has_value)
+      ;
+    else if (strcmp(argv[i], "--address") == 0)
+      settings.address = value;
+    else if (strcmp(argv[i], "--port") == 0)
+      settings.service = value;
+    else if (strcmp(argv[i], "--cert") == 0)
+      settings.certificate = value;
+    else if (strcmp(argv[i], "--key") == 0)
+      settings.private_key = value;
+    else if (strcmp(argv[i], "--user") == 0)
+      settings.user = value;
+    else if (strcmp(argv[i], "--pass") == 0)
+      settings.pass = value;
+    else if (strcmp(argv[i], "--group") == 0)
+      settings.group = value;
+    else if (strcmp(argv[i], "--articles") == 0)
+      settings.articles = strtoul(value, NULL, 10);
+    else if (strcmp(argv[i], "--size") == 0)
+      settings.article_size = strtoul(value, NULL, 10);
+    else if (strcmp(argv[i], "--latency-us") == 0)
+      settings.latency = strtoul(value, NULL, 10);
+    else if (strcmp(argv[i], "--bandwidth") == 0)
+      settings.bandwidth = strtoul(value, NULL, 10);
+    else if (strcmp(argv[i], "--total-bandwidth") == 0)
+      settings.total_bandwidth = strtoul(value, NULL, 10);
+    else if (strcmp(argv[i], "--miss") == 0)
+      settings.miss_rate = strtod(value, NULL);
+    else if (strcmp(argv[i], "--disconnect") == 0)
+      settings.disconnect_rate = strtod(value, NULL);
+    else
+      has_value = false;
+    
+    if (!has_value)
+    {
+      cerr << "usage: " << argv[0] << " [--address host] [--port port] [--secure] [--cert file --key file]" << endl
+           << "       [--user name --pass password] [--group name] [--articles count] [--size bytes]" << endl
+           << "       [--latency-us micros] [--bandwidth bytes/s] [--total-bandwidth bytes/s]" << endl
+           << "       [--miss fraction] [--disconnect fraction]" << endl;
+      return 1;
+    }
+    
+    ++i;
+  }
+  
+  try
+  {
+    nntp::mock_server server(settings);
+    
+    signal(SIGINT, interrupt);
+    signal(SIGTERM, interrupt);
+    
+    cout << "listening on " << settings.address << ":" << server.port() << (settings.secure ? " (tls)" : "") << endl;
+    
+    // report once a second until interrupted
+    while (!interrupted)
+    {
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+      
+      cout << server.connections() << " connections, " << server.commands() << " commands, "
+           << server.upload_speed() / 1000 << " kB/s, " << server.disconnects() << " dropped" << endl;
+    }
+    
+    server.stop();
+  }
+  catch (std::exception& e)
+  {
+    cerr << "mock server failed: " << e.what() << endl;
+    return 1;
+  }
+  
+  return 0;
+}
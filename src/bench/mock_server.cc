@@ -0,0 +1,583 @@
+/**
+ * This file is part of libnntp.
+ *
+ * libnntp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnntp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "mock_server.h"
+#include "stream_encoder.h"
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <ctime>
+#include <algorithm>
+#include <openssl/x509.h>
+
+namespace nntp
+{
+  namespace
+  {
+    // a part of a response
+    typedef std::pair<const char *, std::size_t>  piece;
+    
+    // a quick pseudo random generator, the same seed gives the same connection
+    struct generator
+    {
+      uint64_t  state;  // current state, never zero
+      
+      generator(uint64_t seed) : state(seed * 2654435761u + 88172645463325252ull) {}
+      
+      uint32_t next()
+      {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return (uint32_t) (state >> 16);
+      }
+      
+      double fraction()
+      {
+        return next() / 4294967296.0;
+      }
+    };
+    
+    // add a string as a piece of the response
+    void add(std::vector<piece>& response, const std::string& text)
+    {
+      response.push_back(piece(text.data(), text.size()));
+    }
+  }
+  
+  // default settings
+  mock_settings::mock_settings() :
+  address("127.0.0.1"),
+  service("0"),
+  secure(false),
+  group("alt.binaries.mock"),
+  articles(1000),
+  article_size(716800),
+  latency(0),
+  bandwidth(0),
+  total_bandwidth(0),
+  miss_rate(0),
+  disconnect_rate(0)
+  {}
+  
+  // start the server
+  mock_server::mock_server(const mock_settings& settings) :
+  settings(settings),
+  acceptor(service),
+  context(boost::asio::ssl::context::sslv23),
+  stopping(false),
+  accepted(0),
+  served(0),
+  dropped(0)
+  {
+    boost::asio::ip::tcp::resolver          resolver(service);  // resolves the address to listen on
+    boost::asio::ip::tcp::resolver::query   query(settings.address, settings.service);
+    boost::asio::ip::tcp::endpoint          endpoint = *resolver.resolve(query);
+    std::vector<char>                       data(settings.article_size);  // the decoded article
+    generator                               random(settings.article_size);
+    yenc::stream_encoder                    encoder("mock.bin", (long) data.size());
+    
+    // one body for all articles, so serving does not depend on the speed of the encoder
+    for (std::size_t i = 0; i < data.size(); ++i)
+      data[i] = (char) random.next();
+    
+    std::string encoded(encoder.encoded_size(data.size()), 0);
+    
+    encoded.resize(encoder.feed(data.data(), data.size(), &encoded[0], encoded.size()));
+    body  = encoder.header() + encoded + encoder.footer();
+    lines = std::to_string(std::count(body.begin(), body.end(), '\n'));
+    
+    if (settings.secure)
+      setup_tls();
+    
+    throttle.limit(settings.total_bandwidth);
+    
+    acceptor.open(endpoint.protocol());
+    acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+    acceptor.bind(endpoint);
+    acceptor.listen(boost::asio::socket_base::max_connections);
+    
+    listener = std::thread([this]() { listen(); });
+  }
+  
+  // stop the server
+  mock_server::~mock_server()
+  {
+    stop();
+  }
+  
+  // set up tls
+  void mock_server::setup_tls()
+  {
+    context.set_options(boost::asio::ssl::context::default_workarounds | boost::asio::ssl::context::no_sslv2 | boost::asio::ssl::context::no_sslv3);
+    
+    // clients resume sessions by id as well as by ticket
+    SSL_CTX_set_session_id_context(context.native_handle(), (const unsigned char *) "mock", 4);
+    
+    if (!settings.certificate.empty())
+    {
+      context.use_certificate_chain_file(settings.certificate);
+      context.use_private_key_file(settings.private_key, boost::asio::ssl::context::pem);
+      return;
+    }
+    
+    // nobody checks the certificate of a loopback server, so make one up
+    EVP_PKEY      *key      = NULL;
+    EVP_PKEY_CTX  *generate = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL);
+    X509          *cert     = X509_new();
+    X509_NAME     *name     = X509_get_subject_name(cert);
+    
+    EVP_PKEY_keygen_init(generate);
+    EVP_PKEY_CTX_set_ec_paramgen_curve_nid(generate, NID_X9_62_prime256v1);
+    EVP_PKEY_keygen(generate, &key);
+    EVP_PKEY_CTX_free(generate);
+    
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_get_notBefore(cert), 0);
+    X509_gmtime_adj(X509_get_notAfter(cert), 365 * 86400L);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char *) "localhost", -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    X509_set_pubkey(cert, key);
+    X509_sign(cert, key, EVP_sha256());
+    
+    SSL_CTX_use_certificate(context.native_handle(), cert);
+    SSL_CTX_use_PrivateKey(context.native_handle(), key);
+    
+    // the context keeps its own references
+    X509_free(cert);
+    EVP_PKEY_free(key);
+  }
+  
+  // accept connections
+  void mock_server::listen()
+  {
+    while (!stopping)
+    {
+      plain_socket              *socket = new plain_socket(service);  // the next connection
+      boost::system::error_code error;
+      
+      acceptor.accept(*socket, error);
+      
+      if (error || stopping)
+      {
+        delete socket;
+        continue;
+      }
+      
+      // responses go out in a few large writes, do not hold back the last one
+      socket->set_option(boost::asio::ip::tcp::no_delay(true), error);
+      
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        
+        open.insert(socket);
+      }
+      
+      ++accepted;
+      std::thread([this, socket]() { serve(socket); }).detach();
+    }
+  }
+  
+  // serve a single connection
+  void mock_server::serve(plain_socket *socket)
+  {
+    unsigned  seed  = (unsigned) accepted.load();  // seed for the dropped connections
+    
+    try
+    {
+      if (settings.secure)
+      {
+        tls_socket  stream(*socket, context);
+        
+        stream.handshake(boost::asio::ssl::stream_base::server);
+        converse(stream, seed);
+      }
+      else
+        converse(*socket, seed);
+    }
+    catch (std::exception&)
+    {
+      // the client went away, or we dropped it
+    }
+    
+    boost::system::error_code error;
+    
+    socket->close(error);
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    open.erase(socket);
+    delete socket;
+    
+    // still under the lock, stop() may destroy the server as soon as it sees the last connection go
+    finished.notify_all();
+  }
+  
+  // answer commands on a connection
+  template <typename stream_type>
+  void mock_server::converse(stream_type& stream, unsigned seed)
+  {
+    boost::asio::streambuf  input;                    // data received but not handled yet
+    rate_limiter            limiter(&throttle);       // the bandwidth of this connection
+    generator               random(seed);             // decides when to drop the connection
+    bool                    authenticated = settings.user.empty();  // whether commands are allowed
+    std::string             user;                     // the username given with AUTHINFO USER
+    bool                    selected = false;         // whether the group is selected
+    std::size_t             current = 0;              // the current article number
+    
+    limiter.limit(settings.bandwidth);
+    
+    std::string greeting = "200 mock server ready, posting not allowed\r\n";
+    
+    send(stream, limiter, greeting.data(), greeting.size());
+    
+    while (!stopping)
+    {
+      std::string         line;       // the command line
+      std::string         command;    // the command, upper case
+      std::string         argument;   // everything after the command
+      std::string         status;     // the status line of the response
+      std::string         extra;      // text following the status line
+      std::vector<piece>  response;   // the response to send
+      bool                quit = false;  // whether to close afterwards
+      
+      // clients do not always send the carriage return
+      boost::asio::read_until(stream, input, '\n');
+      
+      std::istream  in(&input);
+      std::getline(in, line);
+      
+      if (!line.empty() && line[line.size() - 1] == '\r')
+        line.erase(line.size() - 1);
+      
+      std::size_t space = line.find(' ');
+      
+      command = line.substr(0, space);
+      std::transform(command.begin(), command.end(), command.begin(), ::toupper);
+      
+      if (space != std::string::npos)
+        argument = line.substr(space + 1);
+      
+      // give the network some latency
+      if (settings.latency > 0)
+        std::this_thread::sleep_for(std::chrono::microseconds(settings.latency));
+      
+      ++served;
+      
+      if (command == "QUIT")
+      {
+        status  = "205 closing connection\r\n";
+        quit    = true;
+      }
+      else if (command == "MODE")
+        status  = "200 posting not allowed\r\n";
+      else if (command == "CAPABILITIES")
+      {
+        status  = "101 capability list follows\r\n";
+        extra   = "VERSION 2\r\nREADER\r\nOVER\r\nAUTHINFO USER\r\n.\r\n";
+      }
+      else if (command == "DATE")
+      {
+        char      date[32];
+        time_t    now = time(NULL);
+        
+        strftime(date, sizeof(date), "111 %Y%m%d%H%M%S\r\n", gmtime(&now));
+        status  = date;
+      }
+      else if (command == "AUTHINFO")
+      {
+        std::string kind  = argument.substr(0, argument.find(' '));
+        std::string value = argument.find(' ') == std::string::npos ? "" : argument.substr(argument.find(' ') + 1);
+        
+        std::transform(kind.begin(), kind.end(), kind.begin(), ::toupper);
+        
+        if (kind == "USER")
+        {
+          user    = value;
+          status  = "381 password required\r\n";
+        }
+        else if (kind == "PASS" && (settings.user.empty() || (user == settings.user && value == settings.pass)))
+        {
+          authenticated = true;
+          status  = "281 authentication accepted\r\n";
+        }
+        else
+          status  = "481 authentication failed\r\n";
+      }
+      else if (!authenticated)
+        status  = "480 authentication required\r\n";
+      else if (command == "GROUP")
+      {
+        if (argument == settings.group)
+        {
+          selected  = true;
+          current   = settings.articles > 0 ? 1 : 0;
+          status    = "211 " + std::to_string(settings.articles) + " " + std::to_string(current) + " " + std::to_string(settings.articles) + " " + settings.group + "\r\n";
+        }
+        else
+          status    = "411 no such group\r\n";
+      }
+      else if (command == "STAT" || command == "HEAD" || command == "BODY" || command == "ARTICLE")
+      {
+        std::size_t number  = 0;  // the article asked for
+        bool        by_id   = !argument.empty() && argument[0] == '<';
+        
+        if (by_id)
+        {
+          char    *end;
+          
+          number  = strtoul(argument.c_str() + 1, &end, 10);
+          
+          if (strcmp(end, "@mock>") != 0)
+            number  = 0;
+        }
+        else if (!selected)
+          status  = "412 no newsgroup selected\r\n";
+        else if (argument.empty())
+          number  = current;
+        else
+          number  = strtoul(argument.c_str(), NULL, 10);
+        
+        if (!status.empty())
+          ;
+        else if (!exists(number))
+          status  = by_id ? "430 no such article\r\n" : (argument.empty() ? "420 current article number is invalid\r\n" : "423 no article with that number\r\n");
+        else
+        {
+          std::string id  = " <" + std::to_string(number) + "@mock>";
+          
+          // a number makes the article the current one
+          if (!by_id)
+            current = number;
+          
+          if (command == "STAT")
+            status  = "223 " + std::to_string(by_id ? 0 : number) + id + "\r\n";
+          else if (command == "HEAD")
+          {
+            status  = "221 " + std::to_string(by_id ? 0 : number) + id + "\r\n";
+            extra   = headers(number) + ".\r\n";
+          }
+          else if (command == "BODY")
+            status  = "222 " + std::to_string(by_id ? 0 : number) + id + "\r\n";
+          else
+          {
+            status  = "220 " + std::to_string(by_id ? 0 : number) + id + "\r\n";
+            extra   = headers(number) + "\r\n";
+          }
+          
+          // the body goes out straight from the shared copy
+          if (command == "BODY" || command == "ARTICLE")
+          {
+            add(response, status);
+            add(response, extra);
+            add(response, body);
+            response.push_back(piece(".\r\n", 3));
+          }
+        }
+      }
+      else if (command == "OVER" || command == "XOVER")
+      {
+        std::size_t first = current;  // first article of the range
+        std::size_t last  = current;  // last article of the range
+        
+        if (!argument.empty())
+        {
+          std::size_t dash  = argument.find('-');
+          
+          first = strtoul(argument.c_str(), NULL, 10);
+          last  = dash == std::string::npos ? first : (dash + 1 == argument.size() ? settings.articles : strtoul(argument.c_str() + dash + 1, NULL, 10));
+        }
+        
+        for (std::size_t number = std::max<std::size_t>(first, 1); selected && number <= std::min(last, settings.articles); ++number)
+        {
+          if (exists(number))
+            extra += std::to_string(number) + "\tmock" + std::to_string(number) + ".bin yEnc (1/1)\tmock <mock@localhost>\t01 Jan 2015 00:00:00 GMT\t<" + std::to_string(number) + "@mock>\t\t" + std::to_string(body.size()) + "\t" + lines + "\r\n";
+        }
+        
+        if (!selected)
+          status  = "412 no newsgroup selected\r\n";
+        else if (extra.empty())
+          status  = "423 no articles in that range\r\n";
+        else
+        {
+          status  = "224 overview information follows\r\n";
+          extra  += ".\r\n";
+        }
+      }
+      else
+        status  = "500 unknown command\r\n";
+      
+      if (response.empty())
+      {
+        add(response, status);
+        add(response, extra);
+      }
+      
+      // sometimes the connection breaks halfway through a response
+      if (settings.disconnect_rate > 0 && random.fraction() < settings.disconnect_rate)
+      {
+        std::size_t total = 0;  // size of the whole response
+        
+        for (std::size_t i = 0; i < response.size(); ++i)
+          total += response[i].second;
+        
+        for (std::size_t i = 0, left = total / 2; i < response.size() && left > 0; ++i)
+        {
+          std::size_t size  = std::min(left, response[i].second);
+          
+          send(stream, limiter, response[i].first, size);
+          left -= size;
+        }
+        
+        ++dropped;
+        return;
+      }
+      
+      for (std::size_t i = 0; i < response.size(); ++i)
+        send(stream, limiter, response[i].first, response[i].second);
+      
+      if (quit)
+        return;
+    }
+  }
+  
+  // send a response
+  template <typename stream_type>
+  void mock_server::send(stream_type& stream, rate_limiter& limiter, const char *data, std::size_t length)
+  {
+    while (length > 0)
+    {
+      std::size_t allowed = limiter.acquire(length);  // what the bandwidth allows right now
+      
+      boost::asio::write(stream, boost::asio::buffer(data, allowed));
+      sent.record(allowed);
+      
+      data    += allowed;
+      length  -= allowed;
+    }
+  }
+  
+  // check whether an article is available
+  bool mock_server::exists(std::size_t number)
+  {
+    if (number < 1 || number > settings.articles)
+      return false;
+    
+    // the same articles are missing every time
+    return generator(number).fraction() >= settings.miss_rate;
+  }
+  
+  // headers of an article
+  std::string mock_server::headers(std::size_t number)
+  {
+    std::string id  = std::to_string(number);
+    
+    return "From: mock <mock@localhost>\r\n"
+           "Newsgroups: " + settings.group + "\r\n"
+           "Subject: mock" + id + ".bin yEnc (1/1)\r\n"
+           "Message-ID: <" + id + "@mock>\r\n"
+           "Date: Thu, 01 Jan 2015 00:00:00 GMT\r\n"
+           "Bytes: " + std::to_string(body.size()) + "\r\n"
+           "Lines: " + lines + "\r\n";
+  }
+  
+  // port the server listens on
+  std::string mock_server::port()
+  {
+    return std::to_string(acceptor.local_endpoint().port());
+  }
+  
+  // change the bandwidth of all connections
+  void mock_server::limit(std::size_t bytes_per_second)
+  {
+    throttle.limit(bytes_per_second);
+  }
+  
+  // connections accepted
+  std::size_t mock_server::connections()
+  {
+    return accepted;
+  }
+  
+  // commands answered
+  std::size_t mock_server::commands()
+  {
+    return served;
+  }
+  
+  // connections dropped on purpose
+  std::size_t mock_server::disconnects()
+  {
+    return dropped;
+  }
+  
+  // bytes sent
+  std::uint64_t mock_server::bytes_sent()
+  {
+    return sent.bytes();
+  }
+  
+  // speed right now
+  std::size_t mock_server::upload_speed()
+  {
+    return sent.rate();
+  }
+  
+  // stop the server
+  void mock_server::stop()
+  {
+    if (stopping.exchange(true))
+      return;
+    
+    // wake the listener with a connection of our own
+    {
+      boost::system::error_code       error;
+      boost::asio::ip::tcp::endpoint  endpoint = acceptor.local_endpoint(error);
+      plain_socket                    wake(service);
+      
+      if (endpoint.address().is_unspecified())
+        endpoint.address(boost::asio::ip::address_v4::loopback());
+      
+      wake.connect(endpoint, error);
+    }
+    
+    if (listener.joinable())
+      listener.join();
+    
+    acceptor.close();
+    
+    // connections waiting for bandwidth should not wait any longer
+    throttle.limit(0);
+    
+    std::unique_lock<std::mutex> lock(mutex);
+    
+    // breaking the sockets makes every connection thread finish
+    for (std::set<plain_socket *>::iterator socket = open.begin(); socket != open.end(); ++socket)
+    {
+      boost::system::error_code error;
+      
+      (*socket)->shutdown(boost::asio::ip::tcp::socket::shutdown_both, error);
+    }
+    
+    finished.wait(lock, [this]() { return open.empty(); });
+  }
+}
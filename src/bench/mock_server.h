@@ -0,0 +1,225 @@
+/**
+ * This file is part of libnntp.
+ *
+ * libnntp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnntp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MOCK_SERVER_H
+#define MOCK_SERVER_H 1
+
+#include <string>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+
+#include "rate_meter.h"
+#include "rate_limiter.h"
+
+namespace nntp
+{
+  /**
+   * How the mock server behaves
+   */
+  struct mock_settings
+  {
+    std::string   address;        // address to listen on
+    std::string   service;        // port to listen on, "0" picks a free one
+    bool          secure;         // whether connections start with a tls handshake
+    std::string   certificate;    // pem certificate for tls, a self-signed one is made when empty
+    std::string   private_key;    // pem key belonging to the certificate
+    std::string   user;           // username to require with AUTHINFO, empty for none
+    std::string   pass;           // password to require with AUTHINFO
+    std::string   group;          // name of the only group
+    std::size_t   articles;       // number of articles in the group
+    std::size_t   article_size;   // decoded size of each article
+    std::size_t   latency;        // delay before every response, in microseconds
+    std::size_t   bandwidth;      // bytes per second per connection, zero for no limit
+    std::size_t   total_bandwidth;// bytes per second over all connections, zero for no limit
+    double        miss_rate;      // fraction of the articles that are missing, answered with 430
+    double        disconnect_rate;// chance that a command gets the connection dropped halfway
+    
+    /**
+     * Constructor, a fast plain server on a free loopback port with a thousand 700 KiB articles
+     */
+    mock_settings();
+  };
+  
+  /**
+   * @class  nntp::mock_server
+   *
+   * A loopback usenet server for load tests, serving a single group of synthetic yEnc
+   * articles. It answers MODE READER, CAPABILITIES, AUTHINFO, GROUP, STAT, HEAD, BODY,
+   * ARTICLE, OVER (and XOVER), DATE and QUIT. Articles are numbered 1 up to the number of
+   * articles and have message ids like <12@mock>. Every article carries the same encoded
+   * body, which is made once, so serving costs no more than copying it to the socket.
+   *
+   * Latency, bandwidth, missing articles and dropped connections can be injected to see
+   * how a client copes. Missing articles are picked by number, so asking again gives the
+   * same answer. Each connection is served by its own thread.
+   */
+  class mock_server
+  {
+  private:
+    typedef boost::asio::ip::tcp::socket        plain_socket;
+    typedef boost::asio::ssl::stream<plain_socket&> tls_socket;
+    
+    mock_settings                   settings;   // how the server behaves
+    boost::asio::io_service         service;    // io_service required by boost::asio
+    boost::asio::ip::tcp::acceptor  acceptor;   // accepts new connections
+    boost::asio::ssl::context       context;    // tls settings for secure connections
+    std::string                     body;       // the encoded body served for every article
+    std::string                     lines;      // number of lines in the body, for the headers
+    rate_limiter                    throttle;   // caps the bandwidth of all connections together
+    rate_meter                      sent;       // measures the bytes sent
+    std::atomic<bool>               stopping;   // set when the server stops
+    std::atomic<std::size_t>        accepted;   // number of connections accepted
+    std::atomic<std::size_t>        served;     // number of commands answered
+    std::atomic<std::size_t>        dropped;    // number of connections dropped on purpose
+    std::mutex                      mutex;      // protects the members below
+    std::condition_variable         finished;   // signalled when a connection ends
+    std::set<plain_socket *>        open;       // sockets of the connections being served
+    std::thread                     listener;   // accepts connections
+    
+    mock_server(const mock_server&);
+    mock_server& operator=(const mock_server&);
+    
+    /**
+     * Set up tls, with the configured certificate or a self-signed one
+     */
+    void    setup_tls();
+    
+    /**
+     * Accept connections until the server stops
+     */
+    void    listen();
+    
+    /**
+     * Serve a single connection until it closes
+     *
+     * @param  socket  the connection
+     */
+    void    serve(plain_socket *socket);
+    
+    /**
+     * Answer commands on a connection, plain or secure
+     *
+     * @param  stream  the connection
+     * @param  seed    seed for the dropped connections
+     */
+    template <typename stream_type>
+    void    converse(stream_type& stream, unsigned seed);
+    
+    /**
+     * Send a response, keeping to the bandwidth
+     *
+     * @param  stream      the connection
+     * @param  limiter     the limiter of the connection
+     * @param  data        the response
+     * @param  length      the number of bytes to send
+     */
+    template <typename stream_type>
+    void    send(stream_type& stream, rate_limiter& limiter, const char *data, std::size_t length);
+    
+    /**
+     * Check whether an article is available
+     *
+     * @param  number  the article number
+     * @return whether the article can be served
+     */
+    bool    exists(std::size_t number);
+    
+    /**
+     * Build the headers of an article
+     *
+     * @param  number  the article number
+     * @return the headers, each line terminated by \r\n
+     */
+    std::string headers(std::size_t number);
+  public:
+    /**
+     * Start the server
+     *
+     * @throws boost::system::system_error when the address cannot be used
+     *
+     * @param  settings    how the server behaves
+     */
+    mock_server(const mock_settings& settings);
+    
+    /**
+     * Destructor, stops the server
+     */
+    ~mock_server();
+    
+    /**
+     * Get the port the server listens on, useful when it was picked by the system
+     *
+     * @return the port as a string, ready for nntp::connect()
+     */
+    std::string port();
+    
+    /**
+     * Change the bandwidth of all connections together while running
+     *
+     * @param  bytes_per_second    the new limit, zero for no limit
+     */
+    void    limit(std::size_t bytes_per_second);
+    
+    /**
+     * Get the number of connections accepted so far
+     *
+     * @return the number of connections
+     */
+    std::size_t connections();
+    
+    /**
+     * Get the number of commands answered so far
+     *
+     * @return the number of commands
+     */
+    std::size_t commands();
+    
+    /**
+     * Get the number of connections dropped on purpose so far
+     *
+     * @return the number of connections
+     */
+    std::size_t disconnects();
+    
+    /**
+     * Get the number of bytes sent so far
+     *
+     * @return the number of bytes
+     */
+    std::uint64_t bytes_sent();
+    
+    /**
+     * Get the speed at which data is sent right now
+     *
+     * @return the number of bytes per second
+     */
+    std::size_t upload_speed();
+    
+    /**
+     * Stop accepting connections, close the open ones and wait for them to finish
+     */
+    void    stop();
+  };
+}
+
+#endif /* MOCK_SERVER_H */
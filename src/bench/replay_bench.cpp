@@ -0,0 +1,294 @@
+/**
+ * This file is part of libnntp.
+ *
+ * libnntp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnntp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "nntp.h"
+#include "session_replay.h"
+#include "decoded_article.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+namespace
+{
+  /**
+   * Where to record a session from
+   */
+  struct recording
+  {
+    std::string path;       // the capture to write
+    std::string host;       // hostname
+    std::string service;    // service name or port
+    bool        secure;     // whether to use ssl
+    std::string user;       // username, empty when no login is needed
+    std::string pass;       // password
+    std::string group;      // the group to take articles from
+    long        count;      // number of most recent articles to fetch
+    std::size_t depth;      // pipeline depth
+  };
+  
+  /**
+   * The outcome of playing back a capture once
+   */
+  struct result
+  {
+    double      seconds;    // time spent
+    std::size_t responses;  // status lines read
+    std::size_t articles;   // bodies decoded
+    uint64_t    decoded;    // decoded bytes
+    std::size_t errors;     // bodies that did not decode or failed the checksum
+  };
+  
+  // record a session with a real server
+  int record(const recording& settings)
+  {
+    nntp::nntp  connection;     // the connection to record
+    std::string status;         // status line of the group
+    long        first;          // first article in the group
+    long        last;           // last article in the group
+    std::size_t bodies  = 0;    // bodies received
+    
+    // start before connecting, so the greeting is included
+    if (!connection.capture(settings.path))
+    {
+      cerr << "unable to create " << settings.path << endl;
+      return 1;
+    }
+    
+    if (!(settings.secure ? connection.secureConnect(settings.host, settings.service) : connection.connect(settings.host, settings.service)))
+    {
+      cerr << "unable to connect to " << settings.host << endl;
+      return 1;
+    }
+    
+    if (!settings.user.empty() && !connection.login(settings.user, settings.pass))
+    {
+      cerr << "login failed" << endl;
+      return 1;
+    }
+    
+    // 211 count first last group
+    if (connection.process_command("GROUP " + settings.group + "\n", status) != 211 || sscanf(status.c_str(), "%*d %*d %ld %ld", &first, &last) != 2)
+    {
+      cerr << "unable to open " << settings.group << ": " << status << endl;
+      return 1;
+    }
+    
+    for (long number = std::max(first, last - settings.count + 1); number <= last; ++number)
+    {
+      connection.pipeline("BODY " + std::to_string(number) + "\n", [&](int code, const std::string&, std::string&) {
+        if (code == 222)
+          ++bodies;
+      });
+    }
+    
+    connection.flush_pipeline(settings.depth);
+    connection.disconnect();
+    
+    cout << "recorded " << bodies << " bodies to " << settings.path << endl;
+    
+    return 0;
+  }
+  
+  // play back a capture once, parsing and decoding everything in it
+  result replay(nntp::session_replay& source)
+  {
+    nntp::nntp          connection;                 // the connection playing back the capture
+    std::string         status;                     // the current status line
+    std::string         body;                       // the current multi-line response
+    std::vector<char>   target;                     // decoded data, reused for every body
+    result              outcome = { 0, 0, 0, 0, 0 };
+    
+    source.rewind();
+    
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    
+    if (connection.replay(source))
+    {
+      // the greeting
+      ++outcome.responses;
+      
+      try
+      {
+        // responses until the capture runs out
+        for (;;)
+        {
+          int code = connection.read_lines(status);
+          
+          ++outcome.responses;
+          
+          if (!nntp::has_multiline_data(code))
+            continue;
+          
+          const char  *data;
+          std::size_t length;
+          
+          body.clear();
+          
+          while (connection.read_multiline_block(data, length))
+            body.append(data, length);
+          
+          body.append(data, length);
+          
+          // only bodies are decoded, an article starts with its headers
+          if (code != 222)
+            continue;
+          
+          try
+          {
+            nntp::decoded_article article(body.data(), (int) body.size(), false);
+            
+            target.resize(std::max(target.size(), article.decoded_size()));
+            article.decode(target.data(), target.size());
+            
+            if (article.check() == nntp::crc_mismatch)
+              ++outcome.errors;
+            else
+              outcome.decoded += article.decoded_size();
+            
+            ++outcome.articles;
+          }
+          catch (nntp::decode_exception&)
+          {
+            ++outcome.errors;
+          }
+        }
+      }
+      catch (nntp::network_exception&)
+      {
+        // the end of the capture
+      }
+    }
+    
+    outcome.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    return outcome;
+  }
+  
+  // print how to use the program
+  int usage(const char *name)
+  {
+    cerr << "usage: " << name << " [--paced] [--repeat count] [--json] capture" << endl
+         << "       " << name << " --record capture --host host [--port port] [--tls] [--user user --pass pass]" << endl
+         << "       " << std::string(strlen(name), ' ') << " --group group [--count articles] [--depth commands]" << endl;
+    
+    return 1;
+  }
+}
+
+int main(int argc, const char * argv[])
+{
+  recording   settings  = { "", "", "", false, "", "", "", 100, 16 };
+  std::string path;             // the capture to play back
+  bool        paced     = false;// keep the original timing
+  bool        json      = false;// print machine readable results
+  int         repeat    = 5;    // number of times to play back the capture
+  
+  // parse the arguments
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "--paced") == 0)
+      paced = true;
+    else if (strcmp(argv[i], "--json") == 0)
+      json = true;
+    else if (strcmp(argv[i], "--tls") == 0)
+      settings.secure = true;
+    else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+      repeat = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+      settings.path = argv[++i];
+    else if (strcmp(argv[i], "--host") == 0 && i + 1 < argc)
+      settings.host = argv[++i];
+    else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+      settings.service = argv[++i];
+    else if (strcmp(argv[i], "--user") == 0 && i + 1 < argc)
+      settings.user = argv[++i];
+    else if (strcmp(argv[i], "--pass") == 0 && i + 1 < argc)
+      settings.pass = argv[++i];
+    else if (strcmp(argv[i], "--group") == 0 && i + 1 < argc)
+      settings.group = argv[++i];
+    else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+      settings.count = atol(argv[++i]);
+    else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc)
+      settings.depth = strtoul(argv[++i], NULL, 10);
+    else if (argv[i][0] != '-' && path.empty())
+      path = argv[i];
+    else
+      return usage(argv[0]);
+  }
+  
+  if (!settings.path.empty())
+  {
+    if (settings.host.empty() || settings.group.empty())
+      return usage(argv[0]);
+    
+    if (settings.service.empty())
+      settings.service = settings.secure ? "nntps" : "nntp";
+    
+    try
+    {
+      return record(settings);
+    }
+    catch (nntp::network_exception&)
+    {
+      cerr << "the connection broke while recording, the capture holds everything up to that point" << endl;
+      return 1;
+    }
+  }
+  
+  if (path.empty())
+    return usage(argv[0]);
+  
+  nntp::session_replay source;
+  
+  if (!source.load(path))
+  {
+    cerr << "unable to load " << path << endl;
+    return 1;
+  }
+  
+  source.pace(paced);
+  
+  if (!json)
+    printf("%s: %.1f MB received in %.2f s, %.1f KB sent\n", path.c_str(), source.size() / 1e6, source.duration() / 1e6, source.requested() / 1e3);
+  
+  for (int i = 0; i < repeat; ++i)
+  {
+    result outcome = replay(source);
+    
+    if (json)
+      printf("{\"run\":%d,\"paced\":%s,\"seconds\":%.4f,\"responses\":%lu,\"articles\":%lu,\"replayed_mbps\":%.2f,\"decoded_mbps\":%.2f,\"errors\":%lu}\n",
+             i, paced ? "true" : "false", outcome.seconds, (unsigned long) outcome.responses, (unsigned long) outcome.articles,
+             source.size() / outcome.seconds / 1e6, outcome.decoded / outcome.seconds / 1e6, (unsigned long) outcome.errors);
+    else
+      printf("run %d: %.3f s, %lu responses, %lu articles, %.1f MB/s replayed, %.1f MB/s decoded, %lu errors\n",
+             i, outcome.seconds, (unsigned long) outcome.responses, (unsigned long) outcome.articles,
+             source.size() / outcome.seconds / 1e6, outcome.decoded / outcome.seconds / 1e6, (unsigned long) outcome.errors);
+    
+    fflush(stdout);
+  }
+  
+  return 0;
+}
@@ -0,0 +1,486 @@
+/**
+ * This file is part of libnntp.
+ *
+ * libnntp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnntp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+
+#include "mock_server.h"
+#include "connection_pool.h"
+#include "group.h"
+#include "decode_pool.h"
+#include "decoded_article.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+namespace
+{
+  typedef std::chrono::steady_clock clock_type;
+  
+  /**
+   * The outcome of a single combination
+   */
+  struct result
+  {
+    bool        secure;       // whether tls was used
+    std::size_t connections;  // number of connections
+    std::size_t depth;        // pipeline depth
+    std::size_t threads;      // number of decode threads
+    double      throughput;   // decoded megabytes per second
+    double      cpu_per_gb;   // cpu seconds spent per decoded gigabyte
+    double      p50;          // median segment latency in milliseconds
+    double      p99;          // 99th percentile segment latency in milliseconds
+    double      peak_rss;     // largest resident set during the run in megabytes
+    std::size_t errors;       // segments that did not arrive or decode correctly
+  };
+  
+  // parse a comma separated list of numbers
+  std::vector<std::size_t> parse_list(const char *text)
+  {
+    std::vector<std::size_t>  values;
+    char                      *end;
+    
+    do
+    {
+      values.push_back(strtoul(text, &end, 10));
+      text = end + 1;
+    }
+    while (*end == ',');
+    
+    return values;
+  }
+  
+  // cpu time used by the process so far, in seconds
+  double cpu_time()
+  {
+    rusage  usage;
+    
+    getrusage(RUSAGE_SELF, &usage);
+    
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+  }
+  
+  // resident set size of the process right now, in bytes
+  std::size_t resident_size()
+  {
+#if defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t      count = MACH_TASK_BASIC_INFO_COUNT;
+    
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) != KERN_SUCCESS)
+      return 0;
+    
+    return info.resident_size;
+#else
+    unsigned long size      = 0;
+    unsigned long resident  = 0;
+    FILE          *statm    = fopen("/proc/self/statm", "r");
+    
+    if (statm == NULL)
+      return 0;
+    
+    if (fscanf(statm, "%lu %lu", &size, &resident) != 2)
+      resident = 0;
+    
+    fclose(statm);
+    
+    return resident * sysconf(_SC_PAGESIZE);
+#endif
+  }
+  
+  // the value below which the given fraction of the samples lies, negative samples are left out
+  double percentile(std::vector<double> samples, double fraction)
+  {
+    samples.erase(std::remove_if(samples.begin(), samples.end(), [](double sample) { return sample < 0; }), samples.end());
+    
+    if (samples.empty())
+      return 0;
+    
+    std::size_t index = std::min(samples.size() - 1, (std::size_t) (fraction * samples.size()));
+    
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    
+    return samples[index];
+  }
+  
+  /**
+   * Run the mock servers in a child process, so their cpu time and memory are not measured
+   *
+   * @param  settings    how the servers behave, secure is ignored
+   * @param  ports       receives the plain and the tls port
+   * @return the process id of the child, or -1
+   */
+  pid_t start_servers(nntp::mock_settings settings, std::string ports[2])
+  {
+    int   to_parent[2];   // the child reports its ports here
+    int   to_child[2];    // closed by the parent when the child should stop
+    char  buffer[64]      = { 0 };
+    
+    if (pipe(to_parent) != 0 || pipe(to_child) != 0)
+      return -1;
+    
+    pid_t child = fork();
+    
+    if (child == 0)
+    {
+      close(to_parent[0]);
+      close(to_child[1]);
+      
+      try
+      {
+        nntp::mock_server plain(settings);
+        
+        settings.secure = true;
+        
+        nntp::mock_server secure(settings);
+        std::string       report = plain.port() + " " + secure.port() + "\n";
+        
+        if (write(to_parent[1], report.data(), report.size()) < 0)
+          _exit(1);
+        
+        // wait until the parent goes away
+        while (read(to_child[0], buffer, sizeof(buffer)) > 0)
+          ;
+        
+        plain.stop();
+        secure.stop();
+      }
+      catch (std::exception& e)
+      {
+        cerr << "mock server failed: " << e.what() << endl;
+      }
+      
+      _exit(0);
+    }
+    
+    close(to_parent[1]);
+    close(to_child[0]);
+    
+    if (child < 0 || read(to_parent[0], buffer, sizeof(buffer) - 1) <= 0)
+      return -1;
+    
+    char  plain[16];
+    char  secure[16];
+    
+    if (sscanf(buffer, "%15s %15s", plain, secure) != 2)
+      return -1;
+    
+    ports[0] = plain;
+    ports[1] = secure;
+    
+    // the child stops once this end is closed, which also happens when we exit
+    close(to_parent[0]);
+    
+    return child;
+  }
+  
+  // download and decode a number of segments with the given combination
+  result run(const std::string& port, const std::string& group_name, std::size_t articles, bool secure, std::size_t connections, std::size_t depth, std::size_t threads, std::size_t segments)
+  {
+    nntp::server_settings       settings;
+    nntp::decode_pool           pool(threads);
+    std::vector<double>         latency(segments, -1);    // latency of every segment in milliseconds, negative when it failed
+    std::vector<std::thread>    workers;                  // one thread per connection
+    std::atomic<std::size_t>    next(0);                  // next segment to request
+    std::atomic<std::size_t>    finished(0);              // segments done, decoded or not
+    std::atomic<std::size_t>    bytes(0);                 // decoded bytes
+    std::atomic<std::size_t>    errors(0);                // segments that failed
+    std::atomic<std::size_t>    peak(resident_size());    // largest resident set seen
+    std::atomic<bool>           done(false);              // stops the memory sampler
+    result                      outcome = { secure, connections, depth, threads, 0, 0, 0, 0, 0, 0 };
+    
+    settings.host         = "127.0.0.1";
+    settings.service      = port;
+    settings.secure       = secure;
+    settings.connections  = connections;
+    
+    nntp::connection_pool connections_pool(settings);
+    
+    // connecting is not part of the measurement
+    if (connections_pool.open() != connections)
+    {
+      outcome.errors = segments;
+      return outcome;
+    }
+    
+    std::thread sampler([&]() {
+      while (!done)
+      {
+        std::size_t current = resident_size();
+        std::size_t seen    = peak;
+        
+        while (current > seen && !peak.compare_exchange_weak(seen, current))
+          ;
+        
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    });
+    
+    double              cpu_start = cpu_time();
+    clock_type::time_point  start = clock_type::now();
+    
+    for (std::size_t c = 0; c < connections; ++c)
+    {
+      workers.push_back(std::thread([&]() {
+        nntp::connection_lease  lease = connections_pool.acquire();
+        nntp::group_ptr         group = lease->open_group(group_name);
+        
+        // queue the next segment, its response queues the one after, so the window stays full
+        std::function<void ()>  request = [&]() {
+          std::size_t             segment = next++;
+          clock_type::time_point  sent    = clock_type::now();
+          
+          if (segment >= segments)
+            return;
+          
+          lease->pipeline("BODY <" + std::to_string(segment % articles + 1) + "@mock>\r\n", [&, segment, sent](int code, const std::string&, std::string& body) {
+            if (code != 222)
+            {
+              ++errors;
+              ++finished;
+            }
+            else
+            {
+              pool.submit(body, [&, segment, sent](nntp::decoded_article_ptr article, std::exception_ptr failure) {
+                if (failure || article->check() != nntp::crc_valid)
+                  ++errors;
+                else
+                {
+                  bytes += article->decoded_size();
+                  latency[segment] = std::chrono::duration<double, std::milli>(clock_type::now() - sent).count();
+                }
+                
+                ++finished;
+              });
+            }
+            
+            request();
+          });
+        };
+        
+        if (!group)
+        {
+          errors += segments;
+          return;
+        }
+        
+        for (std::size_t i = 0; i < depth; ++i)
+          request();
+        
+        try
+        {
+          lease->flush_pipeline(depth);
+        }
+        catch (nntp::network_exception&)
+        {
+          // the segments that did not make it are counted below
+        }
+      }));
+    }
+    
+    for (std::size_t i = 0; i < workers.size(); ++i)
+      workers[i].join();
+    
+    // the last bodies may still be decoding
+    while (finished < std::min<std::size_t>(next, segments) && errors < segments)
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    
+    double elapsed  = std::chrono::duration<double>(clock_type::now() - start).count();
+    double cpu      = cpu_time() - cpu_start;
+    
+    done = true;
+    sampler.join();
+    
+    outcome.throughput  = bytes / elapsed / 1e6;
+    outcome.cpu_per_gb  = bytes > 0 ? cpu / (bytes / 1e9) : 0;
+    outcome.p50         = percentile(latency, 0.5);
+    outcome.p99         = percentile(latency, 0.99);
+    outcome.peak_rss    = peak / 1e6;
+    outcome.errors      = std::min<std::size_t>(errors + (segments - std::min<std::size_t>(finished, segments)), segments);
+    
+    return outcome;
+  }
+  
+  /**
+   * Run a combination in a child process, so its memory and cpu time are measured on their own
+   *
+   * @note   A process rarely gives freed memory back, so measured in a single process the peak
+   *         resident set of every combination would include that of all earlier ones
+   */
+  result measure(const std::string& port, const std::string& group_name, std::size_t articles, bool secure, std::size_t connections, std::size_t depth, std::size_t threads, std::size_t segments)
+  {
+    int     channel[2];   // the child sends its result here
+    result  outcome = { secure, connections, depth, threads, 0, 0, 0, 0, 0, segments };
+    
+    if (pipe(channel) != 0)
+      return outcome;
+    
+    pid_t child = fork();
+    
+    if (child == 0)
+    {
+      close(channel[0]);
+      
+      outcome = run(port, group_name, articles, secure, connections, depth, threads, segments);
+      
+      _exit(write(channel[1], &outcome, sizeof(outcome)) == sizeof(outcome) ? 0 : 1);
+    }
+    
+    close(channel[1]);
+    
+    // a child that died counts every segment as failed
+    if (child > 0 && read(channel[0], &outcome, sizeof(outcome)) != sizeof(outcome))
+      outcome.errors = segments;
+    
+    close(channel[0]);
+    
+    if (child > 0)
+      waitpid(child, NULL, 0);
+    
+    return outcome;
+  }
+  
+  // print a single result as a row of the matrix
+  void print_row(const result& outcome)
+  {
+    printf("%-5s %5lu %5lu %7lu %10.1f %10.2f %9.2f %9.2f %9.1f %7lu\n", outcome.secure ? "tls" : "plain",
+           (unsigned long) outcome.connections, (unsigned long) outcome.depth, (unsigned long) outcome.threads,
+           outcome.throughput, outcome.cpu_per_gb, outcome.p50, outcome.p99, outcome.peak_rss, (unsigned long) outcome.errors);
+  }
+  
+  // print a single result as json
+  void print_json(const result& outcome)
+  {
+    printf("{\"tls\":%s,\"connections\":%lu,\"depth\":%lu,\"threads\":%lu,\"mbps\":%.2f,\"cpu_s_per_gb\":%.3f,\"p50_ms\":%.3f,\"p99_ms\":%.3f,\"peak_rss_mb\":%.1f,\"errors\":%lu}\n",
+           outcome.secure ? "true" : "false", (unsigned long) outcome.connections, (unsigned long) outcome.depth, (unsigned long) outcome.threads,
+           outcome.throughput, outcome.cpu_per_gb, outcome.p50, outcome.p99, outcome.peak_rss, (unsigned long) outcome.errors);
+  }
+}
+
+int main(int argc, const char * argv[])
+{
+  nntp::mock_settings       settings;             // how the mock server behaves
+  std::vector<std::size_t>  connections;          // connection counts to try
+  std::vector<std::size_t>  depths;               // pipeline depths to try
+  std::vector<std::size_t>  threads;              // decode thread counts to try
+  std::vector<bool>         secure;               // plain and/or tls
+  std::size_t               segments  = 400;      // segments per combination
+  bool                      json      = false;    // print machine readable results
+  std::string               ports[2];             // plain and tls port of the mock server
+  
+  connections.push_back(1);
+  connections.push_back(4);
+  connections.push_back(16);
+  depths.push_back(1);
+  depths.push_back(8);
+  depths.push_back(32);
+  threads.push_back(1);
+  threads.push_back(4);
+  secure.push_back(false);
+  secure.push_back(true);
+  
+  // parse the arguments
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "--json") == 0)
+      json = true;
+    else if (strcmp(argv[i], "--connections") == 0 && i + 1 < argc)
+      connections = parse_list(argv[++i]);
+    else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc)
+      depths = parse_list(argv[++i]);
+    else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+      threads = parse_list(argv[++i]);
+    else if (strcmp(argv[i], "--tls") == 0 && i + 1 < argc)
+    {
+      std::string mode = argv[++i];
+      
+      secure.clear();
+      
+      if (mode == "off" || mode == "both")
+        secure.push_back(false);
+      
+      if (mode == "on" || mode == "both")
+        secure.push_back(true);
+    }
+    else if (strcmp(argv[i], "--segments") == 0 && i + 1 < argc)
+      segments = strtoul(argv[++i], NULL, 10);
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+      settings.article_size = strtoul(argv[++i], NULL, 10);
+    else if (strcmp(argv[i], "--latency-us") == 0 && i + 1 < argc)
+      settings.latency = strtoul(argv[++i], NULL, 10);
+    else if (strcmp(argv[i], "--bandwidth") == 0 && i + 1 < argc)
+      settings.bandwidth = strtoul(argv[++i], NULL, 10);
+    else
+    {
+      cerr << "usage: " << argv[0] << " [--json] [--connections 1,4,16] [--depth 1,8,32] [--threads 1,4]" << endl
+           << "       [--tls off|on|both] [--segments count] [--size bytes] [--latency-us micros] [--bandwidth bytes/s]" << endl;
+      return 1;
+    }
+  }
+  
+  // the servers run in their own process, started before we have any threads
+  pid_t server = start_servers(settings, ports);
+  
+  if (server < 0)
+  {
+    cerr << "unable to start the mock server" << endl;
+    return 1;
+  }
+  
+  if (!json)
+    printf("%-5s %5s %5s %7s %10s %10s %9s %9s %9s %7s\n", "mode", "conns", "depth", "threads", "MB/s", "cpu s/GB", "p50 ms", "p99 ms", "rss MB", "errors");
+  
+  for (std::size_t s = 0; s < secure.size(); ++s)
+  {
+    for (std::size_t c = 0; c < connections.size(); ++c)
+    {
+      for (std::size_t d = 0; d < depths.size(); ++d)
+      {
+        for (std::size_t t = 0; t < threads.size(); ++t)
+        {
+          result outcome = measure(ports[secure[s] ? 1 : 0], settings.group, settings.articles, secure[s], connections[c], depths[d], threads[t], segments);
+          
+          if (json)
+            print_json(outcome);
+          else
+            print_row(outcome);
+          
+          fflush(stdout);
+        }
+      }
+    }
+  }
+  
+  // our end of the pipe closes on exit, which stops the servers
+  return 0;
+}
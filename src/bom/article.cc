@@ -18,6 +18,7 @@
 #include "nntp.h"
 #include "group.h"
 #include "article.h"
+#include "async_nntp.h"
 #include "decoded_article.h"
 #include "exceptions.h"
 
@@ -26,14 +27,18 @@ namespace nntp
   // load and cache all headers
   void article::load_headers()
   {
-    char        command[64];// command to send
-    //        char        line[1024]; // buffer for response line
-    //        char        *separator; // pointer to the separator between name and value
-    std::string name;       // header name
-    std::string value;      // header value
+    std::string command;    // command to send
+    const char  *line;      // line of the response
+    std::size_t size;       // length of the line
+    const char  *separator; // pointer to the separator between name and value
+    std::string name;       // name of the last header, for folded lines
+    
+    // articles fetched asynchronously have nothing to load on
+    if (connection == NULL)
+      throw network_exception("No connection to load the article on.");
     
     // create command line
-    sprintf(command, "HEAD %s\n", msg_id);
+    command =   std::string("HEAD ") + msg_id + "\n";
     
     // make sure we are running in the right group
     nntp_group->activate();
@@ -42,42 +47,117 @@ namespace nntp
     if (connection->process_command(command) != 221)
       throw server_exception("Unexpected reply from server.");
     
-    //        // keep going till all the headers are in
-    //        while (connection->read_multiline(line))
-    //        {
-    //            // find the : and cut the line
-    //            separator   =   strchr(line, ':');
-    //            *separator  =   '\0';
-    //            separator   +=  2;
-    //
-    //            // make them into std::strings
-    //            name        =   line;
-    //            value       =   separator;
-    //
-    //            // and put them in the map
-    //            headers[name]=  value;
-    //        }
+    // keep going till all the headers are in
+    while (connection->read_multiline(line, size))
+    {
+      // a folded header continues the value of the previous one
+      if (size > 0 && (line[0] == ' ' || line[0] == '\t'))
+      {
+        if (!name.empty())
+          headers[name].append(line, size);
+        
+        continue;
+      }
+      
+      // find the : and skip the whitespace behind it
+      if ((separator = (const char *) memchr(line, ':', size)) == NULL)
+        continue;
+      
+      name.assign(line, separator - line);
+      
+      for (++separator; separator < line + size && *separator == ' '; ++separator)
+        ;
+      
+      // and put them in the map
+      headers[name].assign(separator, line + size - separator);
+    }
   }
   
   // load and cache body content
   void article::load_content()
   {
-    char    line[64];   // buffer for line to send
+    std::string line;       // line to send
+    const char  *data;      // lines read from the server
+    std::size_t size;       // number of characters read
+    std::string body;       // the body being read
+    bool        more;       // whether more lines follow
     
     // if we already have content, return immediately
-    if (content != NULL)
+    if (loaded)
       return;
     
+    // articles fetched asynchronously have nothing to load on
+    if (connection == NULL)
+      throw network_exception("No connection to load the article on.");
+    
     // build the command
-    sprintf(line, "BODY %s\n", msg_id);
+    line    =   std::string("BODY ") + msg_id + "\n";
     
     // make sure we are running in the right group
     nntp_group->activate();
     
-    std::string output;
-    
     // send it to the server
-    length  =   connection->process_command(line, 222, output);
+    if (connection->process_command(line) != 222)
+      throw server_exception("Unexpected reply from server.");
+    
+    // most bodies are a single yenc part of about this size
+    body.reserve(786432);
+    
+    // copy the lines straight from the receive buffer as they come in
+    do
+    {
+      more    =   connection->read_multiline_block(data, size);
+      body.append(data, size);
+    }
+    while (more);
+    
+    // only keep a complete body
+    content.swap(body);
+    loaded  =   true;
+  }
+  
+  // load body content on an asynchronous connection
+  void article::load_content(async_nntp_ptr connection, completion_callback done)
+  {
+    article_ptr self(this);   // keeps us alive until the response is in
+    
+    // if we already have content, we are done immediately
+    if (loaded)
+    {
+      done(std::exception_ptr());
+      return;
+    }
+    
+    // message ids can be long, so the command is built without a fixed buffer
+    connection->command(std::string("BODY ") + msg_id + "\r\n", [self, done](int code, const std::string&, std::string& body) {
+      if (code == 0)
+        done(std::make_exception_ptr(network_exception("The network connection was unexpectedly closed.")));
+      else if (code != 222)
+        done(std::make_exception_ptr(server_exception("Unexpected reply from server.")));
+      else
+      {
+        // take the body over from the connection
+        self->content.swap(body);
+        self->loaded    =   true;
+        
+        done(std::exception_ptr());
+      }
+    });
+  }
+  
+  // load body content on an asynchronous connection
+  std::future<void> article::load_content(async_nntp_ptr connection)
+  {
+    std::shared_ptr<std::promise<void> > promise(new std::promise<void>());
+    
+    load_content(connection, [promise](std::exception_ptr error) {
+      if (error)
+        promise->set_exception(error);
+      else
+        promise->set_value();
+    });
+    
+    return promise->get_future();
   }
   
   // construct article based on connection, group and article number
@@ -85,8 +165,7 @@ namespace nntp
   connection(connection),
   nntp_group(nntp_group),
   number(number),
-  content(NULL),
-  length(0),
+  loaded(false),
   references(0)
   {
     // allocate memory for message id and copy it
@@ -99,10 +178,6 @@ namespace nntp
   {
     // delete message id
     delete [] msg_id;
-    
-    // and delete content if necessary
-    if (content != NULL)
-      delete [] content;
   }
   
   // get a header by name
@@ -128,7 +203,7 @@ namespace nntp
   void article::body(std::string& value)
   {
     // check if we already have the contents
-    if (content == NULL)
+    if (!loaded)
       load_content();
     
     // copy the body contents into the provided string
@@ -136,20 +211,77 @@ namespace nntp
   }
   
   // get the decoded articles content
-  decoded_article_ptr article::decode()
+  decoded_article_ptr article::decode(bool buffered)
   {
     // if we already cached the results, return them
-    if (decoded != NULL)
+    if (buffered && decoded != NULL)
       return decoded;
     
     // check if we already have the contents or if we can get them
-    if (content == NULL)
+    if (!loaded)
       load_content();
     
+    // the caller decodes an unbuffered article into its own buffer, no need to cache it
+    if (!buffered)
+      return decoded_article_ptr(new decoded_article(content.data(), (int) content.size(), false));
+    
     // create a new decoded article
-    decoded =   new decoded_article(content, length);
+    decoded =   new decoded_article(content.data(), (int) content.size());
     
     // return the result
     return decoded;
   }
+  
+  // download and decode in a pool
+  void article::decode(async_nntp_ptr connection, decode_pool& pool, decode_callback done)
+  {
+    article_ptr self(this);   // keeps us alive until the article is decoded
+    
+    // cache the result, the callback runs on a worker of the pool
+    decode_callback finish  =   [self, done](decoded_article_ptr result, std::exception_ptr error) {
+      self->decoded   =   result;
+      done(result, error);
+    };
+    
+    // if we already cached the results, we are done immediately
+    if (decoded != NULL)
+    {
+      done(decoded, std::exception_ptr());
+      return;
+    }
+    
+    // content that is already there has to stay, so the pool gets a copy
+    if (loaded)
+    {
+      std::string body(content);
+      
+      pool.submit(body, finish);
+      return;
+    }
+    
+    // message ids can be long, so the command is built without a fixed buffer
+    connection->command(std::string("BODY ") + msg_id + "\r\n", [&pool, finish](int code, const std::string&, std::string& body) {
+      if (code == 0)
+        finish(decoded_article_ptr(), std::make_exception_ptr(network_exception("The network connection was unexpectedly closed.")));
+      else if (code != 222)
+        finish(decoded_article_ptr(), std::make_exception_ptr(server_exception("Unexpected reply from server.")));
+      else
+        pool.submit(body, finish);
+    });
+  }
+  
+  // download and decode in a pool
+  std::future<decoded_article_ptr> article::decode(async_nntp_ptr connection, decode_pool& pool)
+  {
+    std::shared_ptr<std::promise<decoded_article_ptr> > promise(new std::promise<decoded_article_ptr>());
+    
+    decode(connection, pool, [promise](decoded_article_ptr result, std::exception_ptr error) {
+      if (error)
+        promise->set_exception(error);
+      else
+        promise->set_value(result);
+    });
+    
+    return promise->get_future();
+  }
 }
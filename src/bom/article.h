@@ -18,16 +18,28 @@
 #ifndef ARTICLE_H
 #define ARTICLE_H 1
 
+#include <functional>
+#include <future>
+#include <exception>
+#include <atomic>
 #include "intrusive_ptr.h"
+#include "decode_pool.h"
 
 namespace nntp
 {
   // forward declarations
   class decoded_article;
+  class async_nntp;
   
   // typedefs
   typedef std::map<std::string, std::string>      header_list;
   typedef boost::intrusive_ptr<decoded_article>   decoded_article_ptr;
+  typedef boost::intrusive_ptr<async_nntp>        async_nntp_ptr;
+  
+  /**
+   * Called when an asynchronous operation is done, with the exception it raised if it failed
+   */
+  typedef std::function<void (std::exception_ptr)> completion_callback;
   
   /**
    * @class  nntp::article
@@ -45,10 +57,10 @@ namespace nntp
     char                    *msg_id;            // message id
     header_list             headers;            // headers for this article
     header_list::iterator   header_iterator;    // iterator for cached headers
-    char*                   content;            // pointer to body contents
-    int                     length;             // length of content
+    std::string             content;            // body contents
+    bool                    loaded;             // whether the body contents are there
     decoded_article_ptr     decoded;            // pointer to decoded article
-    std::size_t             references;         // reference count to this object
+    std::atomic<std::size_t> references;        // reference count to this object, shared with asynchronous handlers
     
     friend void ::boost::intrusive_ptr_add_ref<>(article *p);
     friend void ::boost::intrusive_ptr_release<>(article *p);
@@ -63,7 +75,7 @@ namespace nntp
     /**
      * Construct article based on it's message id and number in the group
      *
-     * @param  connection      connection to our usenet server
+     * @param  connection      connection to our usenet server, NULL when fetched asynchronously
      * @param  nntp_group      group that the article is in
      * @param  number          article number
      * @param  article_id      globally unique message id
@@ -84,6 +96,25 @@ namespace nntp
      */
     void load_content();
     
+    /**
+     * Download the content on an asynchronous connection
+     *
+     * @note   The article may not be used until the callback ran, which happens on the
+     *         thread of the connection. A missing article is reported as a server_exception.
+     *
+     * @param  connection  the connection to download on
+     * @param  done        called when the content is there
+     */
+    void load_content(async_nntp_ptr connection, completion_callback done);
+    
+    /**
+     * Download the content on an asynchronous connection
+     *
+     * @param  connection  the connection to download on
+     * @return a future that is ready when the content is there
+     */
+    std::future<void> load_content(async_nntp_ptr connection);
+    
     /**
      * Get a header
      *
@@ -107,11 +138,38 @@ namespace nntp
     /**
      * Get the contents of the article, decoded
      *
+     * @note   An unbuffered article only has its headers parsed, use decoded_article::decode() to
+     *         write the data to your own buffer while this article is still alive.
+     *
      * @throws network_exception, server_exception, decode_exception
      *
+     * @param  buffered    decode the data into the returned article
      * @return the decoded article
      */
-    decoded_article_ptr decode();
+    decoded_article_ptr decode(bool buffered = true);
+    
+    /**
+     * Download the content on an asynchronous connection and decode it in a pool
+     *
+     * @note   A body that is not loaded yet goes from the connection straight to the pool
+     *         without being kept in the article, so nothing is copied. While the pool is
+     *         full the connection waits for it. The article may not be used until the
+     *         callback ran, which happens on a worker of the pool.
+     *
+     * @param  connection  the connection to download on
+     * @param  pool        the pool to decode in
+     * @param  done        called with the decoded article
+     */
+    void decode(async_nntp_ptr connection, decode_pool& pool, decode_callback done);
+    
+    /**
+     * Download the content on an asynchronous connection and decode it in a pool
+     *
+     * @param  connection  the connection to download on
+     * @param  pool        the pool to decode in
+     * @return the decoded article, once it is ready
+     */
+    std::future<decoded_article_ptr> decode(async_nntp_ptr connection, decode_pool& pool);
   };
 }
 
@@ -0,0 +1,117 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#include "crc_accumulator.h"
+#include "crc32.h"
+
+namespace nntp
+{
+    // construct for a file of a given size
+    crc_accumulator::crc_accumulator(long size) :
+        size(size)
+    {}
+
+    // add the checksum of a part
+    bool crc_accumulator::add(long begin, long length, uint32_t crc)
+    {
+        crc_range_list::iterator    next;       // first range after the part
+        crc_range_list::iterator    previous;   // range before the part
+        crc_range                   range;      // the part, merged with its neighbours
+
+        // parts have to fall within the file
+        if (begin < 1 || length < 0 || begin + length - 1 > size)
+            return false;
+
+        next    =   ranges.lower_bound(begin);
+
+        // the part may not overlap the next range
+        if (next != ranges.end() && next->first < begin + length)
+            return false;
+
+        range.length    =   length;
+        range.crc       =   crc;
+
+        // nor the previous one
+        if (next != ranges.begin())
+        {
+            previous    =   next;
+            --previous;
+
+            if (previous->first + previous->second.length > begin)
+                return false;
+
+            // merge with the previous range if it ends where we begin
+            if (previous->first + previous->second.length == begin)
+            {
+                begin           =   previous->first;
+                range.crc       =   yenc::crc32_combine(previous->second.crc, range.crc, range.length);
+                range.length    +=  previous->second.length;
+
+                ranges.erase(previous);
+            }
+        }
+
+        // merge with the next range if it begins where we end
+        if (next != ranges.end() && next->first == begin + range.length)
+        {
+            range.crc       =   yenc::crc32_combine(range.crc, next->second.crc, next->second.length);
+            range.length    +=  next->second.length;
+
+            ranges.erase(next);
+        }
+
+        // store the merged range
+        ranges[begin]   =   range;
+        return true;
+    }
+
+    // add the checksum of a decoded part
+    bool crc_accumulator::add(decoded_article_ptr part)
+    {
+        // the article counts from zero, we count from one
+        return add(part->begin() + 1, part->decoded_size(), part->crc());
+    }
+
+    // have all the parts been added
+    bool crc_accumulator::complete()
+    {
+        // everything is merged into a single range covering the file
+        return (size == 0 && ranges.empty()) || (ranges.size() == 1 && ranges.begin()->first == 1 && ranges.begin()->second.length == size);
+    }
+
+    // get the checksum of the whole file
+    bool crc_accumulator::crc(uint32_t& value)
+    {
+        if (!complete())
+            return false;
+
+        value   =   ranges.empty() ? 0 : ranges.begin()->second.crc;
+        return true;
+    }
+
+    // check the file against an expected checksum
+    crc_status crc_accumulator::check(uint32_t expected)
+    {
+        uint32_t    value;  // checksum of the file
+
+        // we cannot tell before we have everything
+        if (!crc(value))
+            return crc_unchecked;
+
+        return value == expected ? crc_valid : crc_mismatch;
+    }
+}
@@ -0,0 +1,103 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef CRC_ACCUMULATOR_H
+#define CRC_ACCUMULATOR_H 1
+
+#include <map>
+#include <stdint.h>
+#include "decoded_article.h"
+
+namespace nntp
+{
+    /**
+      * A contiguous range of the file with its checksum
+      */
+    struct crc_range
+    {
+        long        length; // number of bytes in the range
+        uint32_t    crc;    // crc32 of the range
+    };
+
+    // typedefs
+    typedef std::map<long, crc_range>   crc_range_list;
+
+    /**
+      * @class  nntp::crc_accumulator
+      *
+      * Computes the checksum of a whole file from the checksums of its parts, so the file
+      * never has to be read back. Parts may be added in any order: adjacent parts are merged
+      * straight away, so only the gaps between the parts received so far take up memory.
+      */
+    class crc_accumulator
+    {
+        private:
+            long            size;       // total size of the file
+            crc_range_list  ranges;     // ranges received so far, by position of their first byte
+        public:
+            /**
+              * Construct for a file of a given size
+              *
+              * @param  size    total size of the file
+              */
+            crc_accumulator(long size);
+
+            /**
+              * Add the checksum of a part
+              *
+              * @param  begin   position of the first byte of the part in the file, starting at 1
+              * @param  length  number of bytes in the part
+              * @param  crc     crc32 of the part
+              * @return false when the part overlaps a part that was already added
+              */
+            bool add(long begin, long length, uint32_t crc);
+
+            /**
+              * Add the checksum of a decoded part
+              *
+              * @param  part    the decoded article
+              * @return false when the part overlaps a part that was already added
+              */
+            bool add(decoded_article_ptr part);
+
+            /**
+              * Have all the parts been added?
+              *
+              * @return whether the whole file is covered
+              */
+            bool complete();
+
+            /**
+              * Get the checksum of the whole file
+              *
+              * @param  value   set to the crc32 of the file
+              * @return false when not all the parts have been added yet
+              */
+            bool crc(uint32_t& value);
+
+            /**
+              * Check the file against an expected checksum, usually taken
+              * from the =yend line of one of the parts
+              *
+              * @param  expected    the crc32 the file should have
+              * @return crc_unchecked until the file is complete
+              */
+            crc_status check(uint32_t expected);
+    };
+}
+
+#endif /* CRC_ACCUMULATOR_H */
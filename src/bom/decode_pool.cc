@@ -0,0 +1,167 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#include <memory>
+#include <algorithm>
+#include "decode_pool.h"
+
+namespace nntp
+{
+    // start the workers
+    decode_pool::decode_pool(std::size_t threads, std::size_t capacity) :
+        queue(capacity),
+        running(true),
+        sleeping(0)
+    {
+        // one worker per core unless told otherwise
+        if (threads == 0)
+            threads =   std::max(1u, std::thread::hardware_concurrency());
+
+        for (std::size_t i = 0; i < threads; ++i)
+            workers.push_back(std::thread(&decode_pool::work, this));
+    }
+
+    // finish the queued work and stop the workers
+    decode_pool::~decode_pool()
+    {
+        // tell the workers to stop once the queue is empty
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running =   false;
+        }
+
+        wakeup.notify_all();
+
+        for (std::size_t i = 0; i < workers.size(); ++i)
+            workers[i].join();
+    }
+
+    // decode a single body and deliver the result
+    void decode_pool::run(job& current)
+    {
+        decoded_article_ptr result; // the decoded article
+        std::exception_ptr  error;  // or what went wrong
+
+        try
+        {
+            result  =   new decoded_article(current.body.data(), (int) current.body.size());
+        }
+        catch (...)
+        {
+            error   =   std::current_exception();
+        }
+
+        // the encoded body is no longer needed, and the article must not point into it anymore
+        if (result)
+            result->release_source();
+
+        std::string().swap(current.body);
+
+        // an exception from the callback has nowhere to go on a worker thread, it would end the process
+        try
+        {
+            current.done(result, error);
+        }
+        catch (...)
+        {
+        }
+
+        current.done    =   decode_callback();
+    }
+
+    // main loop of a worker thread
+    void decode_pool::work()
+    {
+        job current;    // the body we are decoding
+
+        while (true)
+        {
+            // keep going while there is work
+            if (queue.pop(current))
+            {
+                run(current);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+
+            // announce that we are going to sleep before checking the queue one last
+            // time, so a producer either sees us sleeping or we see its work
+            ++sleeping;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            while (!queue.pop(current))
+            {
+                if (!running)
+                {
+                    --sleeping;
+                    return;
+                }
+
+                wakeup.wait(lock);
+            }
+
+            --sleeping;
+            lock.unlock();
+
+            run(current);
+        }
+    }
+
+    // queue a body for decoding
+    void decode_pool::submit(std::string& body, decode_callback done)
+    {
+        job next;   // the job to queue
+
+        next.body.swap(body);
+        next.done   =   done;
+
+        // wait for room in the queue
+        while (!queue.push(next))
+            std::this_thread::yield();
+
+        // only wake a worker when one is actually sleeping
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (sleeping > 0)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            wakeup.notify_one();
+        }
+    }
+
+    // queue a body for decoding, returning a future for the result
+    std::future<decoded_article_ptr> decode_pool::submit(std::string& body)
+    {
+        std::shared_ptr<std::promise<decoded_article_ptr> > promise(new std::promise<decoded_article_ptr>());
+
+        submit(body, [promise](decoded_article_ptr result, std::exception_ptr error) {
+            if (error)
+                promise->set_exception(error);
+            else
+                promise->set_value(result);
+        });
+
+        return promise->get_future();
+    }
+
+    // number of worker threads
+    std::size_t decode_pool::size()
+    {
+        return workers.size();
+    }
+}
@@ -0,0 +1,126 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef DECODE_POOL_H
+#define DECODE_POOL_H 1
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <exception>
+
+#include "decoded_article.h"
+#include "mpmc_queue.h"
+
+namespace nntp
+{
+    /**
+      * Called with the decoded article, or with the exception that decoding raised
+      */
+    typedef std::function<void (decoded_article_ptr, std::exception_ptr)> decode_callback;
+
+    /**
+      * @class  nntp::decode_pool
+      *
+      * A fixed set of threads decoding article bodies, so that connection threads can hand off
+      * a body and go straight back to receiving the next one. Bodies are passed through a
+      * lock-free queue; idle workers sleep until there is work.
+      */
+    class decode_pool
+    {
+        private:
+            /**
+              * A body waiting to be decoded
+              */
+            struct job
+            {
+                std::string     body;   // encoded article body
+                decode_callback done;   // where to deliver the result
+            };
+
+            mpmc_queue<job>             queue;      // bodies waiting to be decoded
+            std::vector<std::thread>    workers;    // the decoding threads
+            std::atomic<bool>           running;    // cleared to stop the workers
+            std::atomic<int>            sleeping;   // number of workers waiting for work
+            std::mutex                  mutex;      // protects the condition below
+            std::condition_variable     wakeup;     // signalled when work arrives
+
+            decode_pool(const decode_pool&);
+            decode_pool& operator=(const decode_pool&);
+
+            /**
+              * Main loop of a worker thread
+              */
+            void work();
+
+            /**
+              * Decode a single body and deliver the result
+              *
+              * @param  current     the body to decode
+              */
+            void run(job& current);
+        public:
+            /**
+              * Start the workers
+              *
+              * @param  threads     number of workers, defaults to one per cpu core
+              * @param  capacity    maximum number of bodies waiting to be decoded
+              */
+            decode_pool(std::size_t threads = 0, std::size_t capacity = 1024);
+
+            /**
+              * Finish the queued work and stop the workers
+              */
+            ~decode_pool();
+
+            /**
+              * Queue a body for decoding
+              *
+              * @note   Blocks while the queue is full. The callback runs on a worker thread,
+              *         anything it throws is dropped, so handle errors in the callback.
+              *
+              * @param  body    encoded article body, moved into the pool
+              * @param  done    called with the result
+              */
+            void submit(std::string& body, decode_callback done);
+
+            /**
+              * Queue a body for decoding
+              *
+              * @note   Blocks while the queue is full. A decode_exception is rethrown by
+              *         the future's get().
+              *
+              * @param  body    encoded article body, moved into the pool
+              * @return the decoded article, once it is ready
+              */
+            std::future<decoded_article_ptr> submit(std::string& body);
+
+            /**
+              * Get the number of worker threads
+              *
+              * @return the number of workers
+              */
+            std::size_t size();
+    };
+}
+
+#endif /* DECODE_POOL_H */
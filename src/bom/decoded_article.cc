@@ -18,90 +18,81 @@
 
 
 #include "decoded_article.h"
+#include "decoder.h"
+#include "keyword_line.h"
 
 namespace nntp
 {
-    // read a long parameter from the provided line
-    long decoded_article::read_param(const char *param, int length, const char *line_begin)
+    // find the end of the line starting at the provided position
+    const char *decoded_article::find_line_end(const char *line_begin)
     {
-        const char *current;    // pointer to current location in line
+        const char  *line_end;  // pointer to the line feed
 
-        // if we cannot find the parameter just return
-        if ((current = strstr(line_begin, param)) == NULL)
-            return 0;
+        // the last line may not be closed
+        if ((line_end = (const char *) memchr(line_begin, '\n', source_end - line_begin)) == NULL)
+            return source_end;
 
-        // return the parameter
-        return atol(current + length);
+        return line_end;
     }
 
     // parse the yend header line and return a pointer to it's end
     const char *decoded_article::parse_header(const char *source)
     {
-        const char  *line_begin;    // pointer to beginning of line
-        const char  *line_end;      // pointer to end of line
-        char        *current;       // pointer to current character
-        char        *line;          // pointer to line buffer
-        int         line_length;    // length of current line
-
-        // does the source begin straight with =ybegin?
-        if (strncmp(source, "=ybegin ", 8) == 0)
-            line_begin  =   source;
-        // or does it occur further on in the source
-        else if ((line_begin = strstr(source, "\r\n=ybegin ")) != NULL)
-            line_begin  +=  2;  // skip over the \r\n characters
-        // or does it not occur at all
-        else
-            throw decode_exception("Yend header not found, is this really a yend-encoded article");
+        yenc::keyword_line  line;           // parameters of the current line
+        const char          *line_begin;    // pointer to beginning of line
+        const char          *line_end;      // pointer to end of line
+
+        // skip anything in front of the =ybegin line
+        for (line_begin = source; ; line_begin = line_end + 1)
+        {
+            line_end    =   find_line_end(line_begin);
+
+            // found it
+            if (line.parse("=ybegin", line_begin, line_end))
+                break;
+
+            // or does it not occur at all
+            if (line_end == source_end)
+                throw decode_exception("Yend header not found, is this really a yend-encoded article");
+        }
 
-        // find the end of the =ybegin line
-        if ((line_end = strstr(line_begin, "\r\n")) == NULL)
+        // the header line should be closed
+        if (line_end == source_end)
             throw decode_exception("Yend header line not correctly closed");
 
-        // copy it to a temporary buffer
-        line_length =   line_end - line_begin;
-        line        =   (char *) alloca(line_length + 1);
-        strncpy(line, line_begin, line_length);
-        *(line + line_length) = '\0';
-
         // find the size parameter in the line
-        if ((size = read_param(" size=", 6, line)) == 0)
+        if ((size = line.size) == 0)
             throw decode_exception("Required parameter 'size' not found in yend header line");
 
         // find the filename
-        if ((current = strstr(line, " name=")) == NULL)
+        if (!line.has(yenc::param_name))
             throw decode_exception("Required parameter 'name' not found in yend header line");
 
         // copy it to the filename variable
-        orig_name   =   current + 6;
+        orig_name.assign(line.name, line.name_length);
 
         // if it isn't a multipart binary we're done now
-        if ((part = read_param(" part=", 6, line)) == 0)
+        if ((part = line.part) == 0)
             return line_end;
 
         // try to read the (optional) total parameter
-        parts       =   read_param(" total=", 7, line);
+        parts       =   line.total;
 
         // skip to the next line
-        line_begin  =   line_end + 2;
-        line_end    =   strstr(line_begin, "\r\n");
-
-        // find the end of the =ypart line
-        if (line_end == NULL)
-            throw decode_exception("Ypart line not found");
-
-        // copy it to a temporary buffer
-        line_length =   line_end - line_begin;
-        line        =   (char *) alloca(line_length + 1);
-        strncpy(line, line_begin, line_length);
-        *(line + line_length) = '\0';
+        line_begin  =   line_end + 1;
+        line_end    =   find_line_end(line_begin);
 
-        // we should have a line end and the line should start with =ypart
-        if (strncmp(line, "=ypart ", 7) != 0)
+        // the line should start with =ypart
+        if (!line.parse("=ypart", line_begin, line_end))
             throw decode_exception("Required ypart line not found");
 
+        // and be followed by the data
+        if (line_end == source_end)
+            throw decode_exception("Ypart line not correctly closed");
+
         // we should have a begin and an end parameter
-        part_begin  =   read_param(" begin=", 7, line);
-        part_end    =   read_param(" end=", 5, line);
+        part_begin  =   line.begin;
+        part_end    =   line.end;
         part_size   =   part_end - part_begin + 1;
 
         if (part_begin == 0 || part_end == 0)
@@ -127,63 +118,83 @@ namespace nntp
     // parse the yend footer line and return a pointer to it's end
     const char *decoded_article::parse_footer(const char *source)
     {
-        return NULL;
+        yenc::keyword_line  line;           // parameters of the footer line
+        const char          *line_end;      // pointer to end of line
+
+        // the data should be followed by the =yend line
+        line_end    =   find_line_end(source);
+
+        if (!line.parse("=yend", source, line_end))
+            throw decode_exception("Yend footer line not found");
+
+        // the size is that of the part for a multipart binary
+        if (line.size != (long) decoded_size())
+            throw decode_exception("Size in yend footer line does not match the data");
+
+        // the crc32 parameter always covers the whole file
+        has_file_crc    =   line.has(yenc::param_crc32);
+        file_checksum   =   line.crc32;
+
+        // check the part checksum, or the file checksum if this is all of the file
+        if (line.has(yenc::param_pcrc32))
+            status  =   line.pcrc32 == checksum ? crc_valid : crc_mismatch;
+        else if (!multipart() && has_file_crc)
+            status  =   file_checksum == checksum ? crc_valid : crc_mismatch;
+        else
+            status  =   crc_unchecked;
+
+        // done
+        return line_end;
     }
 
     // decode data
-    const char *decoded_article::decode(const char *data, std::size_t expected)
-    {
-        // keep looping until we are at the end of the data
-        while (true) {
-            // line break
-            if (*data == '\r') {
-                // do we have to skip over an extra dot?
-                if (*(data + 2) == '.')
-                    data    +=  3;
-                // end of input stream
-                else if (strncmp(data + 2, "=yend ", 6) == 0) {
-                    data    +=  2;
-                    break;
-                }
-                // normal line break
-                else
-                    data    +=  2;
-            }
-            // do we already have enough characters
-            if (content.size() == expected)
-                // too many characters in input buffer
-                throw decode_exception("Too many characters in input buffer");
-            // do we have an escape character
-            if (*data == '=') {
-                ++data;
-                content.push_back((*data + 150) % 256);
-            }
-            // no escape character
-            else
-                content.push_back((*data + 214) % 256);
-
-            // next character
-            ++data;
-        }
-
-        if (content.size() != expected)
+    const char *decoded_article::decode(const char *data, const char *end, char *target, std::size_t expected)
+    {
+        yenc::decode_state  state   =   yenc::state_data;   // decoder state, we start at the header line break
+        char                *target_end;                    // end of the decoded data
+
+        // decode and checksum everything up to the =yend line
+        target_end  =   target + expected;
+        checksum    =   0;
+        yenc::decode_crc(data, end, target, target_end, state, checksum);
+
+        if (state != yenc::state_end && data != end)
+            // too many characters in input buffer
+            throw decode_exception("Too many characters in input buffer");
+        else if (target != target_end)
             // not enough characters in input buffer
             throw decode_exception("Not enough characters in input buffer");
-        else
-            return data;
+
+        // point back at the start of the =yend line
+        return state == yenc::state_end ? data - 2 : data;
     }
 
     // initialize decoded article given source and its length
-    decoded_article::decoded_article(const char *source, int length) :
+    decoded_article::decoded_article(const char *source, int length, bool buffered) :
+        part(0),
+        parts(0),
+        part_size(0),
+        part_begin(0),
+        part_end(0),
         size(0),
+        body(NULL),
+        source_end(source + length),
+        checksum(0),
+        file_checksum(0),
+        has_file_crc(false),
+        status(crc_unchecked),
         references(0)
     {
-        const char  *current;       // pointer to current character
+        // parse the header
+        body    =   parse_header(source);
 
-        // parse the header, footer, and decode the content
-        current =   parse_header(source);
-        current =   decode(current, parts > 0 ? part_size : size);
-        current =   parse_footer(current);
+        // the caller will provide a buffer to decode to
+        if (!buffered)
+            return;
+
+        // decode into our own buffer
+        content.resize(decoded_size());
+        decode(&content[0], content.size());
     }
 
     // clean up
@@ -202,10 +213,64 @@ namespace nntp
         return part;
     }
 
-    // first byte in the file
+    // offset of the first byte in the file
     long decoded_article::begin()
     {
-        return part_begin;
+        // part_begin is one based, and zero when this is not a multipart binary
+        return part_begin == 0 ? 0 : part_begin - 1;
+    }
+
+    // number of bytes the data decodes to
+    std::size_t decoded_article::decoded_size()
+    {
+        return parts > 0 ? part_size : size;
+    }
+
+    // decode the data straight into the provided buffer
+    std::size_t decoded_article::decode(char *target, std::size_t capacity)
+    {
+        const char  *current;       // pointer to current character
+
+        // we can only decode what we still have
+        if (body == NULL)
+            throw decode_exception("The undecoded source is no longer available");
+
+        // the data has to fit in completely
+        if (capacity < decoded_size())
+            throw decode_exception("Target buffer too small for decoded data");
+
+        // decode the content and parse the footer
+        current =   decode(body, source_end, target, decoded_size());
+        current =   parse_footer(current);
+
+        // we wrote exactly the expected number of bytes
+        return decoded_size();
+    }
+
+    // forget the undecoded source
+    void decoded_article::release_source()
+    {
+        body        =   NULL;
+        source_end  =   NULL;
+    }
+
+    // result of the checksum verification
+    crc_status decoded_article::check()
+    {
+        return status;
+    }
+
+    // checksum of the decoded data
+    uint32_t decoded_article::crc()
+    {
+        return checksum;
+    }
+
+    // checksum of the whole file
+    bool decoded_article::file_crc(uint32_t& value)
+    {
+        value   =   file_checksum;
+        return has_file_crc;
     }
 
     // access the decoded data
@@ -20,12 +20,27 @@
 
 #include <string>
 #include <fstream>
+#include <atomic>
+#include <stdint.h>
 #include <boost/intrusive_ptr.hpp>
 #include "intrusive_ptr.h"
 #include "exceptions.h"
 
 namespace nntp
 {
+    // forward declarations
+    namespace yenc { class stream_decoder; }
+
+    /**
+      * Result of checking the decoded data against the checksum in the =yend line
+      */
+    enum crc_status
+    {
+        crc_unchecked,  // the =yend line did not provide a checksum for this part
+        crc_valid,      // the checksum matches the data
+        crc_mismatch    // the data is corrupt
+    };
+
     /**
       * @class nntp::decoded_article
       *
@@ -40,27 +55,39 @@ namespace nntp
             long        part_begin; // start of part in full file
             long        part_end;   // end of part in full file
             long        size;       // total size of the file
+            const char  *body;      // start of the encoded data
+            const char  *source_end;// end of the encoded source
+            uint32_t    checksum;   // crc32 of the decoded data
+            uint32_t    file_checksum;  // crc32 of the whole file, from the =yend line
+            bool        has_file_crc;   // whether the =yend line had a crc32 for the whole file
+            crc_status  status;     // result of the checksum verification
             std::string content;    // decoded contents
             std::string orig_name;  // pointer to original filename
-            std::size_t references; // reference count to this object
+            std::atomic<std::size_t> references;   // reference count, articles are handed between threads
 
             friend void ::boost::intrusive_ptr_add_ref<>(decoded_article *p);
             friend void ::boost::intrusive_ptr_release<>(decoded_article *p);
+            friend class yenc::stream_decoder;
 
-            long        read_param(const char *param, int length, const char *line_begin);
+            const char  *find_line_end(const char *line_begin);
             const char  *parse_header(const char *source);
             const char  *parse_footer(const char *source);
-            const char  *decode(const char *data, std::size_t expected);
+            const char  *decode(const char *data, const char *end, char *target, std::size_t expected);
         public:
             /**
               * Construct based on undecoded source and length
               *
+              * @note   When the article is not buffered, only the headers are parsed and
+              *         the data must be written to a buffer of your own with decode(). The
+              *         source has to stay valid until then.
+              *
               * @throws decode_exception
               *
-              * @param  source  pointer to array with source
-              * @param  length  size of source array
+              * @param  source      pointer to array with source
+              * @param  length      size of source array
+              * @param  buffered    decode the data into the article itself
               */
-            decoded_article(const char *source, int length);
+            decoded_article(const char *source, int length, bool buffered = true);
 
             /**
               * Destructor
@@ -84,10 +111,65 @@ namespace nntp
             /**
               * At what position in the file does this part begin?
               *
-              * @return position of first byte in the file
+              * @note   yEnc counts from one, this counts from zero
+              *
+              * @return offset of the first byte in the file, zero for single part binaries
               */
             long begin();
 
+            /**
+              * How many bytes does the data decode to?
+              *
+              * @return size of this part, or of the whole file for single part binaries
+              */
+            std::size_t decoded_size();
+
+            /**
+              * Decode the data straight into a buffer, for example the part of
+              * the target file starting at begin()
+              *
+              * @note   Nothing is kept in the article, data() remains empty
+              *
+              * @throws decode_exception, also when the source was released
+              *
+              * @param  target      buffer to decode into
+              * @param  capacity    size of the buffer, at least decoded_size()
+              * @return the number of bytes written
+              */
+            std::size_t decode(char *target, std::size_t capacity);
+
+            /**
+              * Forget the undecoded source, because it is about to go away
+              *
+              * @note   Everything parsed or decoded so far stays available, but
+              *         decode() throws from now on
+              */
+            void release_source();
+
+            /**
+              * Was the data decoded correctly?
+              *
+              * @note   Only valid after the data has been decoded
+              *
+              * @return the result of comparing the data against the =yend checksum
+              */
+            crc_status check();
+
+            /**
+              * Get the checksum of the decoded data
+              *
+              * @return crc32 of this part
+              */
+            uint32_t crc();
+
+            /**
+              * Get the checksum of the whole file, which the =yend line may carry
+              *
+              * @param  value       set to the crc32 of the whole file
+              * @return whether the =yend line provided the checksum
+              */
+            bool file_crc(uint32_t& value);
+
             /**
               * Retrieve the decoded data
               *
@@ -103,6 +185,9 @@ namespace nntp
               */
             const std::string& filename();
     };
+
+    // typedefs
+    typedef boost::intrusive_ptr<decoded_article>   decoded_article_ptr;
 }
 
 #endif /* DECODED_ARTICLE_H */
@@ -17,6 +17,7 @@
 
 #include "group.h"
 #include "article.h"
+#include "async_nntp.h"
 
 namespace nntp
 {
@@ -50,8 +51,8 @@ namespace nntp
   article_ptr group::fetch_article(long number)
   {
     char            command[64];    // command to send to the server
-    std::string     response;  // response from usenet server
-    char            *msg_id;        // pointer to message id
+    char            msg_id[256];    // message id
+    status_line     response;       // response from usenet server
     
     // if the article number is not in range, we have nothing to fetch
     if (number < low || number > high)
@@ -67,8 +68,16 @@ namespace nntp
     if (connection->process_command(command, response) != 223)
       return article_ptr(NULL);
     
-    // message id begins at the < character
-    msg_id      =   NULL; //strchr(response, '<');
+    // 223 number <message id>, the server should send the id, but the number works as well
+    response_field  id  =   response[1];
+    
+    if (id.length == 0 || id.length >= sizeof(msg_id))
+      sprintf(msg_id, "%ld", number);
+    else
+    {
+      memcpy(msg_id, id.data, id.length);
+      msg_id[id.length]   =   '\0';
+    }
     
     // construct new article
     return article_ptr(new article(connection, group_ptr(this), number, msg_id));
@@ -79,8 +88,8 @@ namespace nntp
   {
     char            command[128];     // command to send to the server
     char            id[128];          // message id
-    long            number;           // message number in group
-    std::string     response;         // response from usenet server
+    long            number  =   0;    // message number in group
+    status_line     response;         // response from usenet server
 
     // check if the message id is surrounded by <>'s
     if (msg_id.at(0) == '<')
@@ -101,10 +110,57 @@ namespace nntp
     if (connection->process_command(command, response) != 223)
       return article_ptr(NULL);
     
-    // get the number from the response
-    number  =   atol(response.c_str());
+    // 223 number <message id>, the number is zero when the article is not in the group
+    response.number(0, number);
     
     // construct new article
     return article_ptr(new article(connection, group_ptr(this), number, id));
   }
+  
+  // fetch an article based on it's message id on an asynchronous connection
+  void group::fetch_article(const std::string& msg_id, async_nntp_ptr connection, article_callback done)
+  {
+    group_ptr       self(this);     // keeps us alive until the server answered
+    std::string     id;             // message id surrounded by <>'s
+    
+    // check if the message id is surrounded by <>'s
+    if (msg_id.at(0) == '<')
+      id  =   msg_id;
+    else
+      id  =   "<" + msg_id + ">";
+    
+    // a message id does not need the group to be active
+    connection->command("STAT " + id + "\r\n", [self, id, done](int code, const std::string& response, std::string&) {
+      long        number  =   0;  // message number in group
+      status_line parsed;         // the response, split
+      
+      if (code == 0)
+        done(article_ptr(NULL), std::make_exception_ptr(network_exception("The network connection was unexpectedly closed.")));
+      else if (code != 223)
+        done(article_ptr(NULL), std::exception_ptr());
+      else
+      {
+        // the number follows the status code
+        parsed.parse(response.data(), response.size());
+        parsed.number(0, number);
+        
+        done(article_ptr(new article(NULL, self, number, id.c_str())), std::exception_ptr());
+      }
+    });
+  }
+  
+  // fetch an article based on it's message id on an asynchronous connection
+  std::future<article_ptr> group::fetch_article(const std::string& msg_id, async_nntp_ptr connection)
+  {
+    std::shared_ptr<std::promise<article_ptr> > promise(new std::promise<article_ptr>());
+    
+    fetch_article(msg_id, connection, [promise](article_ptr result, std::exception_ptr error) {
+      if (error)
+        promise->set_exception(error);
+      else
+        promise->set_value(result);
+    });
+    
+    return promise->get_future();
+  }
 }
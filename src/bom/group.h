@@ -18,6 +18,10 @@
 #ifndef GROUP_H
 #define GROUP_H 1
 
+#include <functional>
+#include <future>
+#include <exception>
+#include <atomic>
 #include "intrusive_ptr.h"
 #include "nntp.h"
 
@@ -25,9 +29,16 @@ namespace nntp
 {
     // forward declarations
     class article;
+    class async_nntp;
 
     // typedefs
-    typedef boost::intrusive_ptr<article>  article_ptr;
+    typedef boost::intrusive_ptr<article>       article_ptr;
+    typedef boost::intrusive_ptr<async_nntp>    async_nntp_ptr;
+
+    /**
+      * Called with an article fetched asynchronously, or with the exception that fetching raised
+      */
+    typedef std::function<void (article_ptr, std::exception_ptr)> article_callback;
 
     /**
       * @class  nntp::group
@@ -42,7 +53,7 @@ namespace nntp
             long                        low;                // low water mark in group
             long                        high;               // high water mark in group
             std::string                 group_name;         // name of the group
-            size_t                      references;         // reference count to this object
+            std::atomic<size_t>         references;         // reference count to this object
 
             friend void ::boost::intrusive_ptr_add_ref<>(group *p);
             friend void ::boost::intrusive_ptr_release<>(group *p);
@@ -87,6 +98,28 @@ namespace nntp
               * @param  msg_id      message id
               */
             article_ptr fetch_article(const std::string& msg_id);
+
+            /**
+              * Fetch an article from the group on an asynchronous connection
+              *
+              * @note   The callback runs on the thread of the connection and gets a NULL
+              *         article if it does not exist. Articles fetched this way can only
+              *         load their content on an asynchronous connection.
+              *
+              * @param  msg_id      message id
+              * @param  connection  the connection to ask
+              * @param  done        called with the article
+              */
+            void fetch_article(const std::string& msg_id, async_nntp_ptr connection, article_callback done);
+
+            /**
+              * Fetch an article from the group on an asynchronous connection
+              *
+              * @param  msg_id      message id
+              * @param  connection  the connection to ask
+              * @return the article, once the server answered
+              */
+            std::future<article_ptr> fetch_article(const std::string& msg_id, async_nntp_ptr connection);
     };
 }
 
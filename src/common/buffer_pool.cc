@@ -0,0 +1,158 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#include "buffer_pool.h"
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+
+namespace nntp
+{
+    // constructor
+    buffer_pool::buffer_pool(std::size_t retain) :
+        spare(0),
+        retain(retain),
+        in_use(0)
+    {}
+
+    // destructor
+    buffer_pool::~buffer_pool()
+    {
+        for (std::map<char *, slab>::iterator iterator = slabs.begin(); iterator != slabs.end(); ++iterator)
+            free(iterator->first);
+    }
+
+    // get the pool shared by the whole process
+    buffer_pool& buffer_pool::shared()
+    {
+        // never destroyed: connections with static storage, or on detached threads, may still give buffers back at exit
+        static buffer_pool  *instance   =   new buffer_pool();
+
+        return *instance;
+    }
+
+    // allocate and divide a new slab
+    std::map<char *, buffer_pool::slab>::iterator buffer_pool::grow(std::size_t block)
+    {
+        void    *memory;    // the memory of the slab
+
+        // aligned to its size, so the kernel can map it with a single huge page
+        if (posix_memalign(&memory, slab_size, slab_size) != 0)
+            throw std::bad_alloc();
+
+#ifdef MADV_HUGEPAGE
+        madvise(memory, slab_size, MADV_HUGEPAGE);
+#endif
+
+        slab&   added   =   slabs[(char *) memory];
+
+        added.block =   block;
+        added.used  =   0;
+
+        // hand out from the start of the slab first
+        for (std::size_t offset = slab_size; offset > 0; offset -= block)
+            added.free.push_back((char *) memory + offset - block);
+
+        spare   +=  slab_size;
+
+        return slabs.find((char *) memory);
+    }
+
+    // take a buffer
+    char* buffer_pool::acquire(std::size_t& size)
+    {
+        std::size_t                         block   =   smallest;   // size of the buffer we hand out
+        std::map<char *, slab>::iterator    source;                 // the slab to take it from
+
+        while (block < size && block < largest)
+            block   <<= 1;
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // a slab in use comes first, so unused ones stay unused and can be released
+        std::map<char *, slab>::iterator    unused  =   slabs.end();
+
+        for (source = slabs.begin(); source != slabs.end(); ++source)
+        {
+            if (source->second.block != block || source->second.free.empty())
+                continue;
+
+            if (source->second.used > 0)
+                break;
+
+            if (unused == slabs.end())
+                unused  =   source;
+        }
+
+        if (source == slabs.end())
+            source  =   unused != slabs.end() ? unused : grow(block);
+
+        if (source->second.used++ == 0)
+            spare   -=  slab_size;
+
+        char    *buffer =   source->second.free.back();
+
+        source->second.free.pop_back();
+        in_use  +=  block;
+        size    =   block;
+
+        return buffer;
+    }
+
+    // return a buffer
+    void buffer_pool::release(char *buffer)
+    {
+        if (buffer == NULL)
+            return;
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // the slab starting at or before the buffer holds it
+        std::map<char *, slab>::iterator    source  =   --slabs.upper_bound(buffer);
+
+        source->second.free.push_back(buffer);
+        in_use  -=  source->second.block;
+
+        if (--source->second.used > 0)
+            return;
+
+        // the slab is unused, keep it only while we are below the limit
+        if (spare + slab_size > retain)
+        {
+            free(source->first);
+            slabs.erase(source);
+        }
+        else
+            spare   +=  slab_size;
+    }
+
+    // get the number of bytes handed out
+    std::size_t buffer_pool::used()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        return in_use;
+    }
+
+    // get the number of bytes allocated
+    std::size_t buffer_pool::reserved()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        return slabs.size() * slab_size;
+    }
+}
@@ -0,0 +1,131 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H 1
+
+#include <cstddef>
+#include <map>
+#include <vector>
+#include <mutex>
+
+namespace nntp
+{
+    /**
+      * @class  nntp::buffer_pool
+      *
+      * Hands out receive buffers to connections, so memory is only used by connections that
+      * are actually receiving. Buffers come in powers of two between smallest and largest and
+      * are carved from slabs of two megabytes, each slab holding buffers of a single size.
+      * Slabs are aligned to their size and the kernel is asked to back them with huge pages
+      * where it can. Slabs that are no longer used are kept up to a limit, so connections
+      * going idle and busy again do not keep allocating.
+      *
+      * Buffers are taken and returned when a connection becomes busy or idle, not for every
+      * read, so a single lock is all the protection needed.
+      */
+    class buffer_pool
+    {
+        public:
+            enum
+            {
+                slab_size   =   2097152,    // size of a slab, a huge page on most systems
+                smallest    =   16384,      // size of the smallest buffer
+                largest     =   1048576     // size of the largest buffer
+            };
+        private:
+            /**
+              * Memory divided into buffers of a single size
+              */
+            struct slab
+            {
+                std::size_t         block;  // size of the buffers
+                std::vector<char *> free;   // buffers not handed out
+                std::size_t         used;   // number of buffers handed out
+            };
+
+            std::mutex                  mutex;      // protects the members below
+            std::map<char *, slab>      slabs;      // all slabs, by address
+            std::size_t                 spare;      // bytes in slabs with no buffer handed out
+            std::size_t                 retain;     // bytes of unused slabs to keep around
+            std::size_t                 in_use;     // bytes handed out
+
+            buffer_pool(const buffer_pool&);
+            buffer_pool& operator=(const buffer_pool&);
+
+            /**
+              * Allocate and divide a new slab
+              *
+              * @throws std::bad_alloc
+              *
+              * @param  block   size of the buffers in the slab
+              * @return the new slab
+              */
+            std::map<char *, slab>::iterator grow(std::size_t block);
+        public:
+            /**
+              * Constructor
+              *
+              * @param  retain  bytes of unused slabs to keep for later
+              */
+            buffer_pool(std::size_t retain = 2 * slab_size);
+
+            /**
+              * Destructor, every buffer must be returned by now
+              */
+            ~buffer_pool();
+
+            /**
+              * Get the pool shared by the whole process
+              *
+              * @note   The shared pool is never destroyed, so it outlives every connection
+              *
+              * @return the shared pool
+              */
+            static buffer_pool& shared();
+
+            /**
+              * Take a buffer
+              *
+              * @throws std::bad_alloc
+              *
+              * @param  size    the size needed, set to the size of the buffer, which may be
+              *                 larger; a size above largest gets the largest buffer
+              * @return the buffer
+              */
+            char* acquire(std::size_t& size);
+
+            /**
+              * Return a buffer
+              *
+              * @param  buffer  a buffer from acquire(), or NULL
+              */
+            void release(char *buffer);
+
+            /**
+              * @return the number of bytes in buffers handed out
+              */
+            std::size_t used();
+
+            /**
+              * @return the number of bytes allocated by the pool
+              */
+            std::size_t reserved();
+    };
+}
+
+#endif /* BUFFER_POOL_H */
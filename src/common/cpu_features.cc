@@ -0,0 +1,87 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#include "cpu_features.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace nntp
+{
+#if defined(__x86_64__) || defined(__i386__)
+    // read the extended control register to see which register states the os saves
+    static unsigned long long read_xcr0()
+    {
+        unsigned int    eax;    // lower half of the register
+        unsigned int    edx;    // upper half of the register
+
+        // xgetbv with ecx = 0
+        __asm__ volatile (".byte 0x0f, 0x01, 0xd0" : "=a" (eax), "=d" (edx) : "c" (0));
+
+        return ((unsigned long long) edx << 32) | eax;
+    }
+#endif
+
+    // query the processor for its features
+    static cpu_features detect()
+    {
+        cpu_features    features = { false, false, false, false, false, false };
+
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned int        eax, ebx, ecx, edx; // cpuid registers
+        unsigned long long  xcr0 = 0;           // register states saved by the os
+        bool                os_avx;             // os saves ymm registers
+        bool                os_avx512;          // os saves zmm and opmask registers
+
+        // leaf 1 holds the basic feature flags
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+            return features;
+
+        features.sse2   =   (edx & bit_SSE2) != 0;
+        features.ssse3  =   (ecx & bit_SSSE3) != 0;
+        features.sse41  =   (ecx & bit_SSE4_1) != 0;
+        features.pclmul =   (ecx & bit_PCLMUL) != 0;
+
+        // the wide registers are only usable if the os saves them on a context switch
+        if (ecx & bit_OSXSAVE)
+            xcr0    =   read_xcr0();
+
+        os_avx      =   (xcr0 & 0x06) == 0x06;
+        os_avx512   =   (xcr0 & 0xe6) == 0xe6;
+
+        // leaf 7 holds the extended feature flags
+        if (__get_cpuid_max(0, 0) >= 7)
+        {
+            __cpuid_count(7, 0, eax, ebx, ecx, edx);
+
+            features.avx2       =   os_avx && (ebx & bit_AVX2) != 0;
+            features.avx512bw   =   os_avx512 && (ebx & bit_AVX512F) != 0 && (ebx & bit_AVX512BW) != 0;
+        }
+#endif
+
+        return features;
+    }
+
+    // detect the features of the current processor
+    const cpu_features& cpu()
+    {
+        static const cpu_features features = detect();
+
+        return features;
+    }
+}
@@ -0,0 +1,51 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H 1
+
+namespace nntp
+{
+    /**
+      * @struct nntp::cpu_features
+      *
+      * Instruction set extensions available on the processor we are running on. The features
+      * are only reported when both the cpu and the operating system support them, so it is safe
+      * to use the matching code paths whenever a flag is set.
+      */
+    struct cpu_features
+    {
+        bool    sse2;       // sse2 integer instructions
+        bool    ssse3;      // supplemental sse3 (pshufb)
+        bool    sse41;      // sse4.1
+        bool    pclmul;     // carry-less multiplication
+        bool    avx2;       // 256-bit integer instructions
+        bool    avx512bw;   // 512-bit byte and word instructions
+    };
+
+    /**
+      * Detect the features of the current processor
+      *
+      * @note   Detection is done once, on first use. Subsequent calls
+      *         return the cached result.
+      *
+      * @return the detected features
+      */
+    const cpu_features& cpu();
+}
+
+#endif /* CPU_FEATURES_H */
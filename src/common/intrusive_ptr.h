@@ -28,11 +28,9 @@ namespace boost
 
     template <typename T> inline void intrusive_ptr_release(T *p)
     {
-        // decrement reference count
-        --(p->references);
-
-        // delete p when no more references exist
-        if (p->references == 0)
+        // decrement reference count and delete p when no more references exist,
+        // in a single step so atomic counters can be shared between threads
+        if (--(p->references) == 0)
             delete p;
     } 
 }
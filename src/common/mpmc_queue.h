@@ -0,0 +1,166 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H 1
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace nntp
+{
+    /**
+      * @class  nntp::mpmc_queue
+      *
+      * A bounded lock-free queue for any number of producers and consumers, after Dmitry
+      * Vyukov's design. Every cell carries a sequence number telling whether it is ready to
+      * be written or read, so producers and consumers only contend on their own position.
+      */
+    template <typename T> class mpmc_queue
+    {
+        private:
+            /**
+              * A single slot in the queue
+              */
+            struct cell
+            {
+                std::atomic<std::size_t>    sequence;   // position this cell is ready for
+                T                           data;       // the queued item
+            };
+
+            cell                        *cells;         // ring of cells
+            std::size_t                 mask;           // capacity - 1, to wrap positions
+            char                        padding1[64];   // keep the positions on their own cache lines
+            std::atomic<std::size_t>    enqueue_pos;    // next position to write
+            char                        padding2[64];
+            std::atomic<std::size_t>    dequeue_pos;    // next position to read
+            char                        padding3[64];
+
+            mpmc_queue(const mpmc_queue&);
+            mpmc_queue& operator=(const mpmc_queue&);
+        public:
+            /**
+              * Constructor
+              *
+              * @param  capacity    maximum number of items, rounded up to a power of two
+              */
+            mpmc_queue(std::size_t capacity) :
+                enqueue_pos(0),
+                dequeue_pos(0)
+            {
+                std::size_t size = 2;
+
+                while (size < capacity)
+                    size    <<= 1;
+
+                cells   =   new cell[size];
+                mask    =   size - 1;
+
+                for (std::size_t i = 0; i < size; ++i)
+                    cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+
+            /**
+              * Destructor
+              */
+            ~mpmc_queue()
+            {
+                delete [] cells;
+            }
+
+            /**
+              * Add an item to the queue
+              *
+              * @param  item    the item to add, moved from on success
+              * @return false when the queue is full
+              */
+            bool push(T& item)
+            {
+                cell        *target;                                                // cell to write to
+                std::size_t position    =   enqueue_pos.load(std::memory_order_relaxed);
+
+                while (true)
+                {
+                    target  =   &cells[position & mask];
+
+                    std::size_t sequence    =   target->sequence.load(std::memory_order_acquire);
+                    std::ptrdiff_t difference = (std::ptrdiff_t) sequence - (std::ptrdiff_t) position;
+
+                    // the cell is free, try to claim it
+                    if (difference == 0)
+                    {
+                        if (enqueue_pos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                            break;
+                    }
+                    // the cell still holds an item from the previous round, we are full
+                    else if (difference < 0)
+                        return false;
+                    // another producer got here first
+                    else
+                        position    =   enqueue_pos.load(std::memory_order_relaxed);
+                }
+
+                // store the item and mark the cell readable
+                target->data    =   std::move(item);
+                target->sequence.store(position + 1, std::memory_order_release);
+
+                return true;
+            }
+
+            /**
+              * Take an item from the queue
+              *
+              * @param  item    set to the item taken
+              * @return false when the queue is empty
+              */
+            bool pop(T& item)
+            {
+                cell        *source;                                                // cell to read from
+                std::size_t position    =   dequeue_pos.load(std::memory_order_relaxed);
+
+                while (true)
+                {
+                    source  =   &cells[position & mask];
+
+                    std::size_t sequence    =   source->sequence.load(std::memory_order_acquire);
+                    std::ptrdiff_t difference = (std::ptrdiff_t) sequence - (std::ptrdiff_t) (position + 1);
+
+                    // the cell holds an item, try to claim it
+                    if (difference == 0)
+                    {
+                        if (dequeue_pos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                            break;
+                    }
+                    // the cell has not been written yet, we are empty
+                    else if (difference < 0)
+                        return false;
+                    // another consumer got here first
+                    else
+                        position    =   dequeue_pos.load(std::memory_order_relaxed);
+                }
+
+                // take the item and mark the cell writable for the next round
+                item    =   std::move(source->data);
+                source->sequence.store(position + mask + 1, std::memory_order_release);
+
+                return true;
+            }
+    };
+}
+
+#endif /* MPMC_QUEUE_H */
@@ -0,0 +1,376 @@
+/**
+ * This file is part of libnntp.
+ *
+ * libnntp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnntp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "async_nntp.h"
+
+namespace nntp
+{
+  // size of the receive buffer taken from the pool, bodies pass through it in blocks
+  static const std::size_t receive_buffer_size    = 131072;
+  
+  // size the receive buffer may grow to, which is also the longest line we accept
+  static const std::size_t largest_receive_buffer = 1048576;
+  
+  // construct an unconnected connection
+  async_nntp::async_nntp(io_engine& engine, std::size_t depth) :
+  references(0),
+  socket(engine.service(), engine.tls()),
+  reader(buffer_pool::shared(), receive_buffer_size, largest_receive_buffer),
+  state(phase_new),
+  depth(std::max<std::size_t>(depth, 1)),
+  reading(false),
+  in_body(false),
+  code(0)
+  {}
+  
+  // connect, do the tls handshake and log in
+  void async_nntp::start(const server_settings& settings, connect_handler handler)
+  {
+    async_nntp_ptr  self(this);   // keeps us alive until the handlers ran
+    
+    socket.service().post([self, settings, handler]() {
+      // a connection can only be started once
+      if (self->state != phase_new)
+      {
+        handler(boost::asio::error::already_started);
+        return;
+      }
+      
+      self->settings  =   settings;
+      self->started   =   handler;
+      self->state     =   phase_starting;
+      
+      self->socket.async_connect(settings.host, settings.service, settings.secure, [self](const boost::system::error_code& error) {
+        if (error)
+        {
+          self->fail(error);
+          return;
+        }
+        
+        // the greeting is the response to a command we never sent
+        pipelined_command greeting;
+        
+        greeting.handler    =   [self](int code, const std::string&, std::string&) {
+          if (code == 200 || code == 201)
+            self->login();
+          else
+            self->fail(boost::asio::error::connection_refused);
+        };
+        
+        self->in_flight.push_back(std::move(greeting));
+        self->read();
+      });
+    });
+  }
+  
+  // log in once the server greeted us
+  void async_nntp::login()
+  {
+    async_nntp_ptr  self(this);   // keeps us alive until the handlers ran
+    
+    // some servers do not need a login
+    if (settings.user.empty())
+    {
+      finish_start(boost::system::error_code());
+      return;
+    }
+    
+    send("AUTHINFO USER " + settings.user + "\r\n", [self](int code, const std::string&, std::string&) {
+      // the user alone may be enough
+      if (code == 281)
+        self->finish_start(boost::system::error_code());
+      else if (code != 381)
+        self->fail(boost::asio::error::access_denied);
+      else
+      {
+        self->send("AUTHINFO PASS " + self->settings.pass + "\r\n", [self](int code, const std::string&, std::string&) {
+          if (code == 281)
+            self->finish_start(boost::system::error_code());
+          else
+            self->fail(boost::asio::error::access_denied);
+        });
+      }
+    });
+  }
+  
+  // finish start()
+  void async_nntp::finish_start(const boost::system::error_code& error)
+  {
+    connect_handler handler;    // the handler to call
+    
+    state   =   phase_ready;
+    
+    handler.swap(started);
+    
+    if (handler)
+      handler(error);
+    
+    // send whatever was queued in the meantime
+    refill();
+  }
+  
+  // queue a command
+  void async_nntp::command(const std::string& line, response_handler handler)
+  {
+    async_nntp_ptr  self(this);   // keeps us alive until the handlers ran
+    
+    socket.service().post([self, line, handler]() {
+      // nobody is going to answer this one
+      if (self->state == phase_closed)
+      {
+        std::string     body;   // there is no body
+        
+        if (handler)
+          handler(0, "", body);
+        
+        return;
+      }
+      
+      pipelined_command   command;    // the command to queue
+      
+      command.line    =   line;
+      command.handler =   handler;
+      
+      self->queued.push_back(std::move(command));
+      self->refill();
+    });
+  }
+  
+  // send a command right away
+  void async_nntp::send(const std::string& line, response_handler handler)
+  {
+    pipelined_command   command;    // the command to send
+    
+    command.line    =   line;
+    command.handler =   handler;
+    
+    in_flight.push_back(std::move(command));
+    pending +=  line;
+    
+    write();
+    read();
+  }
+  
+  // move queued commands into the window
+  void async_nntp::refill()
+  {
+    // refill once half of the window is answered, so commands go out in batches
+    if (state != phase_ready || in_flight.size() > depth / 2)
+      return;
+    
+    while (!queued.empty() && in_flight.size() < depth)
+    {
+      pending +=  queued.front().line;
+      in_flight.push_back(std::move(queued.front()));
+      queued.pop_front();
+    }
+    
+    write();
+    read();
+  }
+  
+  // start writing the pending commands
+  void async_nntp::write()
+  {
+    async_nntp_ptr  self(this);   // keeps us alive until the handlers ran
+    
+    // one write at a time, the next one takes everything that piled up
+    if (!writing.empty() || pending.empty() || state == phase_closed)
+      return;
+    
+    writing.swap(pending);
+    
+    socket.async_write(writing.data(), writing.size(), [self](const boost::system::error_code& error, std::size_t) {
+      if (error)
+      {
+        self->fail(error);
+        return;
+      }
+      
+      self->writing.clear();
+      self->write();
+    });
+  }
+  
+  // start reading
+  void async_nntp::read()
+  {
+    async_nntp_ptr  self(this);   // keeps us alive until the handlers ran
+    std::size_t     length;       // free space in the buffer
+    char            *space;       // where to read to
+    
+    // one read at a time, and only when a response is expected
+    if (reading || in_flight.empty() || state == phase_closed)
+    {
+      // nothing is expected, so the buffer can go back until there is
+      if (!reading)
+        reader.release();
+      
+      return;
+    }
+    
+    try
+    {
+      space   =   reader.prepare(length);
+    }
+    catch (server_exception&)
+    {
+      // a single line filled the whole buffer
+      fail(boost::asio::error::message_size);
+      return;
+    }
+    
+    reading =   true;
+    
+    socket.async_read_some(space, length, [self](const boost::system::error_code& error, std::size_t bytes) {
+      self->received(error, bytes);
+    });
+  }
+  
+  // handle the outcome of a read
+  void async_nntp::received(const boost::system::error_code& error, std::size_t bytes)
+  {
+    reading =   false;
+    
+    if (error)
+    {
+      fail(error);
+      return;
+    }
+    
+    reader.commit(bytes);
+    
+    process();
+    read();
+  }
+  
+  // hand out all complete responses in the buffer
+  void async_nntp::process()
+  {
+    const char  *data;      // data from the buffer
+    std::size_t length;     // number of characters available
+    bool        last;       // whether the block ends the body
+    status_line parsed;     // the status line, split
+    
+    // handlers may close the connection
+    while (!in_flight.empty() && state != phase_closed)
+    {
+      if (!in_body)
+      {
+        if (!reader.next_line(data, length))
+          break;
+        
+        status.assign(data, length);
+        parsed.parse(data, length);
+        code    =   parsed.code();
+        
+        body.clear();
+        
+        // the body streams in with the next reads, the command decides for the few codes that are ambiguous
+        if (has_multiline_data(code, in_flight.front().line.c_str()))
+        {
+          in_body =   true;
+          continue;
+        }
+      }
+      else
+      {
+        if (!reader.next_block(data, length, last))
+          break;
+        
+        body.append(data, length);
+        
+        if (!last)
+          continue;
+        
+        in_body =   false;
+      }
+      
+      // the oldest command is answered, even if it failed
+      pipelined_command   command =   std::move(in_flight.front());
+      in_flight.pop_front();
+      
+      if (command.handler)
+        command.handler(code, status, body);
+      
+      refill();
+    }
+  }
+  
+  // close the connection and fail all outstanding commands
+  void async_nntp::fail(const boost::system::error_code& error)
+  {
+    std::deque<pipelined_command>   unanswered;     // commands that will not get a response
+    connect_handler                 handler;        // start() handler, if still waiting
+    std::string                     empty;          // body passed to failed commands
+    
+    if (state == phase_closed)
+      return;
+    
+    state   =   phase_closed;
+    socket.close();
+    
+    // sent commands come first, so they are failed in the order they were made
+    unanswered.swap(in_flight);
+    
+    for (std::size_t i = 0; i < queued.size(); ++i)
+      unanswered.push_back(std::move(queued[i]));
+    
+    queued.clear();
+    handler.swap(started);
+    
+    if (handler)
+      handler(error);
+    
+    for (std::size_t i = 0; i < unanswered.size(); ++i)
+    {
+      empty.clear();
+      
+      if (unanswered[i].handler)
+        unanswered[i].handler(0, "", empty);
+    }
+  }
+  
+  // close the connection
+  void async_nntp::close()
+  {
+    async_nntp_ptr  self(this);   // keeps us alive until the handlers ran
+    
+    socket.service().post([self]() {
+      self->fail(boost::asio::error::operation_aborted);
+    });
+  }
+  
+  // number of bytes received
+  std::size_t async_nntp::bytes_received()
+  {
+    return socket.bytes_received();
+  }
+  
+  // download speed of the connection
+  std::size_t async_nntp::download_speed()
+  {
+    return socket.download_speed();
+  }
+  
+  // count the traffic in other meters as well
+  void async_nntp::report_to(rate_meter *download, rate_meter *upload)
+  {
+    socket.report_to(download, upload);
+  }
+}
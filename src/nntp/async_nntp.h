@@ -0,0 +1,204 @@
+/**
+ * This file is part of libnntp.
+ *
+ * libnntp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnntp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ASYNC_NNTP_H
+#define ASYNC_NNTP_H 1
+
+#include <atomic>
+#include <deque>
+#include <vector>
+
+#include "intrusive_ptr.h"
+#include "async_socket.h"
+#include "io_engine.h"
+#include "line_buffer.h"
+#include "nntp.h"
+#include "connection_pool.h"
+
+namespace nntp
+{
+  // forward declarations
+  class async_nntp;
+  
+  // typedefs
+  typedef boost::intrusive_ptr<async_nntp>  async_nntp_ptr;
+  
+  /**
+   * @class  nntp::async_nntp
+   *
+   * A connection to a usenet server driven entirely by completion handlers on an io_engine,
+   * so a handful of threads can keep hundreds of connections busy. start() connects, does the
+   * tls handshake and logs in; command() queues commands that are pipelined like those of
+   * nntp::flush_pipeline(), with bodies collected as they stream in.
+   *
+   * All handlers run on the thread of the io_service the connection was given. The public
+   * functions may be called from any thread, they post their work to that service. Keep the
+   * connection in an async_nntp_ptr; the handlers hold on to it while they are pending.
+   */
+  class async_nntp
+  {
+  private:
+    /**
+     * State of the connection
+     */
+    enum phase
+    {
+      phase_new,        // start() was not called yet
+      phase_starting,   // connecting and logging in
+      phase_ready,      // accepting commands
+      phase_closed      // connection is gone
+    };
+    
+    std::atomic<std::size_t>        references; // reference count to this object
+    async_socket                    socket;     // the connection to the server
+    server_settings                 settings;   // the server we connect to
+    line_buffer                     reader;     // buffer for incoming data, split into lines
+    phase                           state;      // state of the connection
+    connect_handler                 started;    // called when start() is done
+    std::deque<pipelined_command>   queued;     // commands waiting to be sent
+    std::deque<pipelined_command>   in_flight;  // commands waiting for their response, oldest first
+    std::size_t                     depth;      // maximum number of commands in flight
+    std::string                     pending;    // commands to send once the current write is done
+    std::string                     writing;    // commands being written right now
+    bool                            reading;    // whether a read is outstanding
+    bool                            in_body;    // whether the current response has a body coming
+    int                             code;       // status code of the current response
+    std::string                     status;     // status line of the current response
+    std::string                     body;       // data of the current response so far
+    
+    friend void ::boost::intrusive_ptr_add_ref<>(async_nntp *p);
+    friend void ::boost::intrusive_ptr_release<>(async_nntp *p);
+    
+    async_nntp(const async_nntp&);
+    async_nntp& operator=(const async_nntp&);
+    
+    /**
+     * Send a command right away, without waiting for the window
+     *
+     * @param  line    command to send, newline included
+     * @param  handler handler to call with the response
+     */
+    void    send(const std::string& line, response_handler handler);
+    
+    /**
+     * Move queued commands into the window and send them
+     */
+    void    refill();
+    
+    /**
+     * Start writing the pending commands, unless a write is going on already
+     */
+    void    write();
+    
+    /**
+     * Start reading, unless a read is going on already or nothing is expected
+     */
+    void    read();
+    
+    /**
+     * Handle the outcome of a read
+     *
+     * @param  error   error returned by boost
+     * @param  bytes   number of bytes read
+     */
+    void    received(const boost::system::error_code& error, std::size_t bytes);
+    
+    /**
+     * Hand out all complete responses in the buffer
+     */
+    void    process();
+    
+    /**
+     * Log in once the server greeted us
+     */
+    void    login();
+    
+    /**
+     * Finish start(), successfully or not
+     *
+     * @param  error   the outcome
+     */
+    void    finish_start(const boost::system::error_code& error);
+    
+    /**
+     * Close the connection and fail all outstanding commands
+     *
+     * @param  error   reason for closing
+     */
+    void    fail(const boost::system::error_code& error);
+  public:
+    /**
+     * Constructor
+     *
+     * @param  engine  the engine to run on
+     * @param  depth   maximum number of commands in flight
+     */
+    async_nntp(io_engine& engine, std::size_t depth = 16);
+    
+    /**
+     * Connect to the server, do the tls handshake if needed and log in
+     *
+     * @param  settings    the server to connect to
+     * @param  handler     handler to call when the connection is ready, or failed
+     */
+    void    start(const server_settings& settings, connect_handler handler);
+    
+    /**
+     * Queue a command
+     *
+     * @note   Commands queued before the connection is ready are sent once it is. When the
+     *         connection fails, every command that did not get its response yet reaches its
+     *         handler with code 0, so it can be queued elsewhere.
+     *
+     * @param  line    command to send, newline included
+     * @param  handler handler to call with the response
+     */
+    void    command(const std::string& line, response_handler handler);
+    
+    /**
+     * Close the connection
+     */
+    void    close();
+    
+    /**
+     * Get the number of bytes received on this connection
+     *
+     * @return the number of bytes
+     */
+    std::size_t bytes_received();
+    
+    /**
+     * Get the download speed in bytes per second
+     *
+     * @note   Safe to call from any thread
+     *
+     * @return the number of bytes per second
+     */
+    std::size_t download_speed();
+    
+    /**
+     * Count the traffic of this connection in other meters as well, see socket_wrapper::report_to()
+     *
+     * @param  download    meter for the incoming bytes, or NULL
+     * @param  upload      meter for the outgoing bytes, or NULL
+     */
+    void    report_to(rate_meter *download, rate_meter *upload);
+  };
+}
+
+#endif /* ASYNC_NNTP_H */
@@ -0,0 +1,218 @@
+/**
+ * This file is part of libnntp.
+ *
+ * libnntp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnntp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <thread>
+#include "connection_pool.h"
+
+namespace nntp
+{
+  // construct a lease
+  connection_lease::connection_lease(connection_pool *pool, std::size_t slot, nntp *connection) :
+  pool(pool),
+  slot(slot),
+  connection(connection)
+  {}
+  
+  // take over another lease
+  connection_lease::connection_lease(connection_lease&& other) :
+  pool(other.pool),
+  slot(other.slot),
+  connection(other.connection)
+  {
+    // the other lease no longer returns the connection
+    other.pool  =   NULL;
+  }
+  
+  // return the connection to the pool
+  connection_lease::~connection_lease()
+  {
+    if (pool != NULL)
+      pool->release(slot);
+  }
+  
+  // access the leased connection
+  nntp* connection_lease::operator->()
+  {
+    return connection;
+  }
+  
+  // access the leased connection
+  nntp& connection_lease::operator*()
+  {
+    return *connection;
+  }
+  
+  // construct the pool
+  connection_pool::connection_pool(const server_settings& settings, rate_meter *download, rate_meter *upload, rate_limiter *limiter) :
+  settings(settings),
+  received(download),
+  sent(upload),
+  throttle(limiter)
+  {
+    for (std::size_t slot = 0; slot < settings.connections; ++slot)
+    {
+      connections.push_back(std::unique_ptr<nntp>(new nntp));
+      idle.push_back(slot);
+    }
+  }
+  
+  // open and log in a single session
+  bool connection_pool::open(nntp& connection)
+  {
+    bool    connected;  // whether the server greeted us
+    
+    // the traffic of every session adds up in the meters of the pool, and is capped by it
+    connection.report_to(&received, &sent);
+    connection.draw_from(&throttle);
+    
+    try
+    {
+      if (settings.secure)
+        connected   =   connection.secureConnect(settings.host, settings.service);
+      else
+        connected   =   connection.connect(settings.host, settings.service);
+      
+      // log in if the server wants us to
+      if (connected && settings.authenticate && !settings.authenticate(connection))
+      {
+        connection.disconnect();
+        connected   =   false;
+      }
+      else if (connected && !settings.authenticate && !settings.user.empty() && !connection.login(settings.user, settings.pass))
+      {
+        connection.disconnect();
+        connected   =   false;
+      }
+    }
+    catch (network_exception&)
+    {
+      connected   =   false;
+    }
+    catch (server_exception&)
+    {
+      // the server sent something we cannot parse, the session is out of step and cannot be used
+      connection.disconnect();
+      connected   =   false;
+    }
+    catch (...)
+    {
+      // this runs on its own thread, anything escaping it would end the process, and
+      // our own exceptions do not derive from std::exception as far as a catch can see
+      connected   =   false;
+    }
+    
+    // the session waits in the pool until it is leased, it needs no receive buffer until then
+    connection.idle();
+    
+    return connected;
+  }
+  
+  // open all connections in parallel
+  std::size_t connection_pool::open()
+  {
+    std::vector<std::thread>    threads;    // one thread per connection
+    std::vector<char>           opened(connections.size(), 0);  // which connections succeeded
+    std::size_t                 count = 0;  // number of connections that are ready
+    
+    // most of the time is spent waiting for the server, so do them all at once
+    for (std::size_t slot = 0; slot < connections.size(); ++slot)
+      threads.push_back(std::thread([this, slot, &opened]() { opened[slot] = open(*connections[slot]); }));
+    
+    for (std::size_t i = 0; i < threads.size(); ++i)
+      threads[i].join();
+    
+    for (std::size_t slot = 0; slot < opened.size(); ++slot)
+      count   +=  opened[slot];
+    
+    return count;
+  }
+  
+  // lease a connection
+  connection_lease connection_pool::acquire()
+  {
+    std::size_t slot;   // the slot we get
+    
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      
+      // wait until somebody returns a connection
+      while (idle.empty())
+        available.wait(lock);
+      
+      slot    =   idle.back();
+      idle.pop_back();
+    }
+    
+    // the slot is ours now, so a closed session can be replaced without holding the lock
+    if (!connections[slot]->connected())
+    {
+      connections[slot].reset(new nntp);
+      
+      if (!open(*connections[slot]))
+      {
+        // give the slot back, the next lease tries again
+        release(slot);
+        throw network_exception("Unable to reopen connection to " + settings.host);
+      }
+    }
+    
+    return connection_lease(this, slot, connections[slot].get());
+  }
+  
+  // return a leased slot to the pool
+  void connection_pool::release(std::size_t slot)
+  {
+    // a connection waiting in the pool does not need a receive buffer
+    connections[slot]->idle();
+    
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      
+      // connections that are ready go out first, closed ones are replaced as a last resort
+      if (connections[slot]->connected())
+        idle.push_back(slot);
+      else
+        idle.insert(idle.begin(), slot);
+    }
+    
+    available.notify_one();
+  }
+  
+  // number of connections in the pool
+  std::size_t connection_pool::size()
+  {
+    return connections.size();
+  }
+  
+  // combined download speed of all connections
+  std::size_t connection_pool::download_speed()
+  {
+    return received.rate();
+  }
+  
+  // combined upload speed of all connections
+  std::size_t connection_pool::upload_speed()
+  {
+    return sent.rate();
+  }
+  
+  // cap the combined download speed
+  void connection_pool::limit(std::size_t bytes_per_second)
+  {
+    throttle.limit(bytes_per_second);
+  }
+}
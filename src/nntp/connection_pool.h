@@ -0,0 +1,199 @@
+/**
+ * This file is part of libnntp.
+ *
+ * libnntp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnntp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CONNECTION_POOL_H
+#define CONNECTION_POOL_H 1
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "nntp.h"
+
+namespace nntp
+{
+  // forward declarations
+  class connection_pool;
+  
+  /**
+   * Everything needed to open connections to a usenet server
+   */
+  struct server_settings
+  {
+    std::string host;         // hostname
+    std::string service;      // service name or port
+    bool        secure;       // whether to use ssl
+    std::string user;         // username, empty when no login is needed
+    std::string pass;         // password
+    std::size_t connections;  // number of connections the server allows
+    std::function<bool (nntp&)> authenticate; // logs a pooled session in instead of user and pass, if set
+  };
+  
+  /**
+   * @class  nntp::connection_lease
+   *
+   * A connection borrowed from a pool. The connection goes back to the pool when the lease
+   * is destroyed; if it was closed in the meantime the pool replaces it.
+   */
+  class connection_lease
+  {
+  private:
+    connection_pool *pool;      // the pool the connection belongs to
+    std::size_t     slot;       // the slot of the connection in the pool
+    nntp            *connection;// the leased connection
+    
+    connection_lease(const connection_lease&);
+    connection_lease& operator=(const connection_lease&);
+  public:
+    /**
+     * Constructor, used by the pool
+     *
+     * @param  pool        the pool the connection belongs to
+     * @param  slot        the slot of the connection in the pool
+     * @param  connection  the leased connection
+     */
+    connection_lease(connection_pool *pool, std::size_t slot, nntp *connection);
+    
+    /**
+     * Take over another lease
+     *
+     * @param  other   the lease to take over
+     */
+    connection_lease(connection_lease&& other);
+    
+    /**
+     * Destructor, returns the connection to the pool
+     */
+    ~connection_lease();
+    
+    /**
+     * Access the leased connection
+     */
+    nntp*   operator->();
+    nntp&   operator*();
+  };
+  
+  /**
+   * @class  nntp::connection_pool
+   *
+   * Owns all connections to a single usenet server. The connections are opened and logged in
+   * up front, in parallel, and are leased to worker threads with acquire(). A connection that
+   * was closed while leased is replaced by a fresh one before it is handed out again.
+   *
+   * @note   Groups remember the connection they were opened on, so pooled connections are
+   *         best used with commands that name articles by message id.
+   */
+  class connection_pool
+  {
+  private:
+    friend class connection_lease;
+    
+    server_settings                     settings;   // the server to connect to
+    rate_meter                          received;   // incoming bytes of all connections
+    rate_meter                          sent;       // outgoing bytes of all connections
+    rate_limiter                        throttle;   // caps the download speed of all connections together
+    std::vector<std::unique_ptr<nntp> > connections;// one session per slot, destroyed before the meters and limiter it uses
+    std::vector<std::size_t>            idle;       // slots that are not leased
+    std::mutex                          mutex;      // protects the members above
+    std::condition_variable             available;  // signalled when a slot is returned
+    
+    connection_pool(const connection_pool&);
+    connection_pool& operator=(const connection_pool&);
+    
+    /**
+     * Open and log in a single session
+     *
+     * @param  connection  the session to open
+     * @return whether the session is ready for use
+     */
+    bool    open(nntp& connection);
+    
+    /**
+     * Return a leased slot to the pool
+     *
+     * @param  slot    the slot to return
+     */
+    void    release(std::size_t slot);
+  public:
+    /**
+     * Constructor
+     *
+     * @note   No connections are made until open() is called
+     *
+     * @param  settings    the server to connect to
+     * @param  download    meter that also counts the incoming bytes, for a total over several servers
+     * @param  upload      meter that also counts the outgoing bytes
+     * @param  limiter     limiter shared with the pools of other servers, or NULL
+     */
+    connection_pool(const server_settings& settings, rate_meter *download = NULL, rate_meter *upload = NULL, rate_limiter *limiter = NULL);
+    
+    /**
+     * Open and log in all connections in parallel
+     *
+     * @note   Connections that fail to open are retried when they are leased
+     *
+     * @return the number of connections that are ready for use
+     */
+    std::size_t open();
+    
+    /**
+     * Lease a connection, waiting until one is available
+     *
+     * @throws network_exception when a closed connection cannot be reopened
+     *
+     * @return the lease
+     */
+    connection_lease    acquire();
+    
+    /**
+     * Get the number of connections in the pool
+     *
+     * @return the number of connections
+     */
+    std::size_t size();
+    
+    /**
+     * Get the combined download speed of all connections in bytes per second
+     *
+     * @note   Every connection counts in the meter of the pool as it goes, so this
+     *         includes leased connections and does not lock anything.
+     *
+     * @return the number of bytes per second
+     */
+    std::size_t download_speed();
+    
+    /**
+     * Get the combined upload speed of all connections in bytes per second
+     *
+     * @return the number of bytes per second
+     */
+    std::size_t upload_speed();
+    
+    /**
+     * Cap the combined download speed of all connections
+     *
+     * @note   Can be changed at any time, connections stay open while they wait
+     *
+     * @param  bytes_per_second    the limit, zero for no limit
+     */
+    void    limit(std::size_t bytes_per_second);
+  };
+}
+
+#endif /* CONNECTION_POOL_H */
@@ -0,0 +1,179 @@
+/**
+ * This file is part of libnntp.
+ *
+ * libnntp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnntp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <algorithm>
+#include "line_buffer.h"
+#include "exceptions.h"
+
+namespace nntp
+{
+  // construct an empty buffer
+  line_buffer::line_buffer(buffer_pool& pool, std::size_t initial, std::size_t maximum) :
+  pool(pool),
+  initial(initial),
+  maximum(std::max(initial, maximum)),
+  storage(NULL),
+  capacity(0),
+  position(NULL),
+  end(NULL),
+  filled(false)
+  {}
+  
+  // give the memory back
+  line_buffer::~line_buffer()
+  {
+    pool.release(storage);
+  }
+  
+  // throw away all data
+  void line_buffer::clear()
+  {
+    position    =   storage;
+    end         =   storage;
+  }
+  
+  // give the memory back if all data was processed
+  bool line_buffer::release()
+  {
+    if (position != end)
+      return false;
+    
+    pool.release(storage);
+    
+    storage     =   NULL;
+    capacity    =   0;
+    position    =   NULL;
+    end         =   NULL;
+    filled      =   false;
+    
+    return true;
+  }
+  
+  // move the data to a buffer of twice the size
+  void line_buffer::grow()
+  {
+    std::size_t size    =   capacity * 2;           // size of the new buffer
+    char        *larger =   pool.acquire(size);     // the new buffer
+    
+    memcpy(larger, position, end - position);
+    pool.release(storage);
+    
+    end         =   larger + (end - position);
+    position    =   larger;
+    storage     =   larger;
+    capacity    =   size;
+  }
+  
+  // make room for more data
+  char* line_buffer::prepare(std::size_t& length)
+  {
+    // memory is only taken once data is expected
+    if (storage == NULL)
+    {
+      capacity    =   initial;
+      storage     =   pool.acquire(capacity);
+      position    =   storage;
+      end         =   storage;
+    }
+    
+    // move the unprocessed data to the front to make room
+    if (position != storage)
+    {
+      memmove(storage, position, end - position);
+      end         -=  position - storage;
+      position    =   storage;
+    }
+    
+    // a line that does not fit, or a connection that fills whatever we offer, gets more room
+    if ((end == storage + capacity || filled) && capacity < maximum)
+      grow();
+    
+    // a single line may not fill the whole buffer
+    if (end == storage + capacity)
+      throw server_exception("Line too long for the receive buffer");
+    
+    length  =   storage + capacity - end;
+    filled  =   false;
+    
+    return end;
+  }
+  
+  // add data written after prepare()
+  void line_buffer::commit(std::size_t length)
+  {
+    end     +=  length;
+    filled  =   end == storage + capacity;
+  }
+  
+  // get the next complete line
+  bool line_buffer::next_line(const char *&line, std::size_t& length)
+  {
+    char    *newline;   // newline ending the line
+    
+    // nothing at all while the memory is released
+    if (position == end || (newline = (char *) memchr(position, '\n', end - position)) == NULL)
+      return false;
+    
+    line        =   position;
+    length      =   newline - position;
+    position    =   newline + 1;
+    
+    // the carriage return is not part of the line
+    if (length > 0 && line[length - 1] == '\r')
+      --length;
+    
+    return true;
+  }
+  
+  // get all complete lines of a multi-line block
+  bool line_buffer::next_block(const char *&data, std::size_t& length, bool& last)
+  {
+    char        *complete;  // end of the last complete line
+    const char  *dot;       // dot that may start the terminating line
+    
+    for (complete = end; complete > position && complete[-1] != '\n'; --complete)
+      ;
+    
+    if (complete == position)
+      return false;
+    
+    // blocks always start a line, so only a dot at the start of a line followed by a newline ends it
+    for (dot = position; (dot = (const char *) memchr(dot, '.', complete - dot)) != NULL; ++dot)
+    {
+      if (dot != position && dot[-1] != '\n')
+        continue;
+      
+      if (dot[1] == '\n' || (dot[1] == '\r' && dot + 2 < complete && dot[2] == '\n'))
+      {
+        data        =   position;
+        length      =   dot - position;
+        position    =   (char *) dot + (dot[1] == '\n' ? 2 : 3);
+        last        =   true;
+        
+        return true;
+      }
+    }
+    
+    data        =   position;
+    length      =   complete - position;
+    position    =   complete;
+    last        =   false;
+    
+    return true;
+  }
+}
@@ -0,0 +1,132 @@
+/**
+ * This file is part of libnntp.
+ *
+ * libnntp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnntp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LINE_BUFFER_H
+#define LINE_BUFFER_H 1
+
+#include <cstddef>
+#include "buffer_pool.h"
+
+namespace nntp
+{
+  /**
+   * @class  nntp::line_buffer
+   *
+   * Splits the data received from a usenet server into lines and multi-line blocks without
+   * copying it. The buffer does not read by itself: prepare() and commit() bracket a read
+   * into the free space, after which next_line() and next_block() hand out pointers into
+   * the buffer. Those stay valid until the next call to prepare() or release().
+   *
+   * The memory comes from a buffer_pool when the first data arrives, and can be given back
+   * with release() once everything is processed, so an idle connection holds no buffer at
+   * all. The buffer starts small and doubles, up to a maximum, whenever a read fills all
+   * the space it was offered, as the connection evidently has more data coming.
+   */
+  class line_buffer
+  {
+  private:
+    buffer_pool &pool;      // where the memory comes from
+    std::size_t initial;    // size of the memory to start with
+    std::size_t maximum;    // size the memory may grow to
+    char        *storage;   // the memory holding the data, NULL while released
+    std::size_t capacity;   // size of the memory
+    char        *position;  // start of the data not processed yet
+    char        *end;       // end of the data received so far
+    bool        filled;     // whether the last read filled all the space offered
+    
+    line_buffer(const line_buffer&);
+    line_buffer& operator=(const line_buffer&);
+    
+    /**
+     * Move the data to a buffer of twice the size
+     */
+    void    grow();
+  public:
+    /**
+     * Constructor
+     *
+     * @param  pool        the pool to take memory from
+     * @param  initial     size of the memory to start with
+     * @param  maximum     size the memory may grow to, which limits the length of a line
+     */
+    line_buffer(buffer_pool& pool, std::size_t initial, std::size_t maximum);
+    
+    /**
+     * Destructor, gives the memory back to the pool
+     */
+    ~line_buffer();
+    
+    /**
+     * Throw away all data in the buffer
+     */
+    void    clear();
+    
+    /**
+     * Give the memory back to the pool if all data was processed
+     *
+     * @note   Memory is taken from the pool again by the next prepare(),
+     *         starting at the initial size.
+     *
+     * @return whether the memory was given back
+     */
+    bool    release();
+    
+    /**
+     * Make room for more data
+     *
+     * @note   Unprocessed data is moved to the front, or to a larger buffer,
+     *         which invalidates all pointers handed out before.
+     *
+     * @throws server_exception when a single line fills the largest buffer
+     *
+     * @param  length  set to the number of characters that fit
+     * @return where to write the data
+     */
+    char*   prepare(std::size_t& length);
+    
+    /**
+     * Add data written to the space returned by prepare()
+     *
+     * @param  length  the number of characters written
+     */
+    void    commit(std::size_t length);
+    
+    /**
+     * Get the next complete line
+     *
+     * @param  line    pointer to set to the start of the line
+     * @param  length  set to the length of the line, without the trailing newline
+     * @return false when no complete line is available yet
+     */
+    bool    next_line(const char *&line, std::size_t& length);
+    
+    /**
+     * Get all complete lines of a multi-line block that are available
+     *
+     * @note   The lines are passed on as sent, newlines and dot-stuffing included.
+     *         The terminating line is consumed, but not included.
+     *
+     * @param  data    pointer to set to the start of the lines
+     * @param  length  set to the number of characters available
+     * @param  last    set when the lines end the block
+     * @return false when no complete line is available yet
+     */
+    bool    next_block(const char *&data, std::size_t& length, bool& last);
+  };
+}
+
+#endif /* LINE_BUFFER_H */
@@ -16,23 +16,39 @@
  */
 
 
+#include <vector>
 #include "nntp.h"
 #include "group.h"
+#include "stream_encoder.h"
 
 namespace nntp
 {
+  // size of the receive buffer taken from the pool, it grows while bodies stream in
+  static const std::size_t receive_buffer_size    = 65536;
+  
+  // size the receive buffer may grow to, which is also the longest line we accept
+  static const std::size_t largest_receive_buffer = 1048576;
+  
   // initialize socket and buffer
   void nntp::initialize()
   {
-    // no data is in the buffer yet
-    position        =   buffer;
+    // no data is in the buffer yet, nor do we need one before the first read
+    reader.clear();
+    reader.release();
+  }
+  
+  // read more data from the server into the buffer
+  void nntp::fill()
+  {
+    std::size_t length;     // free space in the buffer
+    char        *space  =   reader.prepare(length);
     
-    // make sure that our buffer is empty
-    buffer[0]       =   '\0';
+    reader.commit(socket.read_some(space, length));
   }
   
   // default constructor
-  nntp::nntp()
+  nntp::nntp() :
+  reader(buffer_pool::shared(), receive_buffer_size, largest_receive_buffer)
   {
     // initialize ourselves
     initialize();
@@ -51,6 +67,9 @@ namespace nntp
     if (!socket.connect(host, service))
       return false;
     
+    // anything left from a previous connection is useless now
+    initialize();
+    
     if (read_lines() != 200)
     {
       socket.close();
@@ -66,6 +85,45 @@ namespace nntp
     if (!socket.secureConnect(host, service))
       return false;
     
+    // anything left from a previous connection is useless now
+    initialize();
+    
+    if (read_lines() != 200)
+    {
+      socket.close();
+      return false;
+    }
+    else
+      return true;
+  }
+  
+  // check whether the connection is still open
+  bool nntp::connected()
+  {
+    return socket.is_open();
+  }
+  
+  // let an io_uring engine receive for the connection
+  bool nntp::attach(uring_engine& engine)
+  {
+    return socket.attach(engine);
+  }
+  
+  // record the traffic to a file
+  bool nntp::capture(const std::string& path)
+  {
+    return socket.capture(path);
+  }
+  
+  // play back a capture instead of connecting
+  bool nntp::replay(session_replay& source)
+  {
+    if (!socket.replay(source))
+      return false;
+    
+    // anything left from a previous connection is useless now
+    initialize();
+    
     if (read_lines() != 200)
     {
       socket.close();
@@ -78,43 +136,96 @@ namespace nntp
   // write a line to the usenet server
   void nntp::write_line(const std::string& line)
   {
-    write_line(line.c_str());
+    write(line.data(), line.size());
   }
   
   // write a line to the usenet server
   void nntp::write_line(const char *line)
   {
+    write(line, strlen(line));
+  }
+  
+  // write data to the usenet server
+  void nntp::write(const char *data, std::size_t length)
+  {
+    const char  *end    =   data + length;  // end of the data
+    
     // now write until there is nothing left
-    while (strlen(line) > 0)
-      line    +=  socket.write_some(line);
+    while (data < end)
+      data    +=  socket.write_some(data, end - data);
   }
   
+  // read the status line from the usenet server
   int nntp::read_lines(std::string& output)
   {
-    // 8kb buffer
-    char buf[8192];
+    const char  *line;      // the status line
+    std::size_t length;     // length of the status line
+    status_line status;     // the status line, split
     
-    // read socket
-    int length        =  socket.read_some(buf, 8192);
+    read_line(line, length);
+    output.assign(line, length);
+    status.parse(line, length);
     
-    // remove last two characters from input which are \r\n
-    buf[length-2]     = '\0';
+    return status.code();
+  }
+  
+  // read the status line from the usenet server
+  int nntp::read_lines()
+  {
+    status_line status;     // the status line, split
     
-    // update output
-    output = buf;
+    return read_status(status);
+  }
+  
+  // read the status line and split it
+  int nntp::read_status(status_line& status)
+  {
+    const char  *line;      // the status line
+    std::size_t length;     // length of the status line
     
-    // return length read
-    return atoi(buf);
+    read_line(line, length);
+    status.parse(line, length);
     
+    return status.code();
   }
   
-  int nntp::read_lines()
+  // read a single line from the usenet server
+  void nntp::read_line(const char *&line, std::size_t& length)
+  {
+    // keep reading until a complete line is in the buffer
+    while (!reader.next_line(line, length))
+      fill();
+  }
+  
+  // read the next line of a multi-line response
+  bool nntp::read_multiline(const char *&line, std::size_t& length)
   {
-    // create returned output
-    std::string output;
+    read_line(line, length);
     
-    // read lines
-    return read_lines(output);
+    // a line holding a single dot ends the response
+    if (line[0] == '.')
+    {
+      if (length == 1)
+        return false;
+      
+      // otherwise the dot was added by the server
+      ++line;
+      --length;
+    }
+    
+    return true;
+  }
+  
+  // read all complete lines of a multi-line response in the buffer
+  bool nntp::read_multiline_block(const char *&data, std::size_t& length)
+  {
+    bool    last;   // whether the block ends the response
+    
+    // we need at least one complete line
+    while (!reader.next_block(data, length, last))
+      fill();
+    
+    return !last;
   }
   
   // write a line to the server and return the response code
@@ -154,6 +265,108 @@ namespace nntp
     
   }
   
+  // write a line to the server and return the split status line
+  int nntp::process_command(const std::string& line, status_line& status)
+  {
+    // send the command to the server
+    write_line(line);
+    
+    // and return the result
+    return read_status(status);
+  }
+  
+  // queue a command to be sent in a pipeline
+  void nntp::pipeline(const std::string& line, response_handler handler)
+  {
+    pipelined_command   command;    // the command to queue
+    
+    command.line    =   line;
+    command.handler =   handler;
+    
+    queued.push_back(std::move(command));
+  }
+  
+  // send all queued commands, keeping several in flight at once
+  void nntp::flush_pipeline(std::size_t depth)
+  {
+    std::deque<pipelined_command>   in_flight;  // commands waiting for their response, oldest first
+    std::vector<boost::asio::const_buffer> batch; // commands to send in a single write
+    std::string                     status;     // status line of the current response
+    std::string                     body;       // data following the status line
+    const char                      *data;      // lines read from the server
+    std::size_t                     length;     // number of characters read
+    
+    // a window of zero would never send anything
+    depth   =   std::max<std::size_t>(depth, 1);
+    
+    try
+    {
+      while (!queued.empty() || !in_flight.empty())
+      {
+        // refill the window once half of it is answered, so commands go out in batches
+        if (in_flight.size() <= depth / 2)
+        {
+          batch.clear();
+          
+          // the lines stay where they are, elements of a deque do not move when it grows
+          while (!queued.empty() && in_flight.size() < depth)
+          {
+            in_flight.push_back(std::move(queued.front()));
+            queued.pop_front();
+            batch.push_back(boost::asio::buffer(in_flight.back().line));
+          }
+          
+          if (!batch.empty())
+            socket.write(batch);
+        }
+        
+        // responses come in the order the commands were sent
+        int code    =   read_lines(status);
+        
+        body.clear();
+        
+        // the command decides for the few codes that are ambiguous
+        if (has_multiline_data(code, in_flight.front().line.c_str()))
+        {
+          bool    more;   // whether more lines follow
+          
+          do
+          {
+            more    =   read_multiline_block(data, length);
+            body.append(data, length);
+          }
+          while (more);
+        }
+        
+        // the command is answered, even if it failed
+        pipelined_command   command =   std::move(in_flight.front());
+        in_flight.pop_front();
+        
+        if (command.handler)
+          command.handler(code, status, body);
+      }
+    }
+    catch (...)
+    {
+      // the stream is out of sync, nothing queued can be sent anymore
+      queued.clear();
+      
+      // the responses still in flight would be read by the next command, so the connection has to go
+      socket.close();
+      initialize();
+      throw;
+    }
+    
+    // all responses are read, so the buffer is only needed again with the next command
+    reader.release();
+  }
+  
+  // give the receive buffer back while idle
+  bool nntp::idle()
+  {
+    return reader.release();
+  }
+  
   // login to the usenet server
   bool nntp::login(const std::string& user, const std::string& pass)
   {
@@ -163,19 +376,17 @@ namespace nntp
   // get a usenet group
   group_ptr nntp::open_group(const std::string& name)
   {
+    status_line response;   // response from the usenet server
+    
     // see if the group exists
-    if (process_command("GROUP "+name+"\n") == 211)
+    if (process_command("GROUP "+name+"\n", response) == 211)
     {
-      char    *save_ptr;  // pointer used by strtok_r
-      long    low;        // low water mark
-      long    high;       // high water mark
-      
-      // not interested in the first part of the line (the estimated number of articles)
-      strtok_r(buffer + 4, " ", &save_ptr);
+      long    low     =   0;  // low water mark
+      long    high    =   0;  // high water mark
       
-      // second and third part are low and high water mark
-      low             =   atol(strtok_r(NULL, " ", &save_ptr));
-      high            =   atol(strtok_r(NULL, " ", &save_ptr));
+      // not interested in the estimated number of articles, the low and high water mark follow it
+      response.number(1, low);
+      response.number(2, high);
       
       // construct the new group
       current_group   =   new group(name, this, low, high);
@@ -201,6 +412,53 @@ namespace nntp
     current_group   =   open_group;
   }
   
+  // post a yenc-encoded binary
+  bool nntp::post(const std::string& headers, std::istream& input, yenc::stream_encoder& encoder)
+  {
+    const std::size_t chunk_size  =   65536;  // number of bytes read from the input at once
+    
+    // the server has to be willing to accept the article
+    if (process_command("POST\n") != 340)
+      return false;
+    
+    std::vector<char> chunk(chunk_size);                      // data read from the input
+    std::vector<char> encoded(encoder.encoded_size(chunk_size));// encoded data
+    long              remaining   =   encoder.part_size();    // number of bytes still to send
+    std::string       header      =   encoder.header();       // the yenc header lines
+    std::vector<boost::asio::const_buffer> buffers;           // everything that goes before the data
+    
+    // the headers are separated from the body by an empty line
+    buffers.push_back(boost::asio::buffer(headers));
+    buffers.push_back(boost::asio::buffer("\r\n", 2));
+    buffers.push_back(boost::asio::buffer(header));
+    socket.write(buffers);
+    
+    // start reading where the part begins
+    input.seekg(encoder.part_offset());
+    
+    while (remaining > 0)
+    {
+      std::size_t length  =   std::min<long>(remaining, chunk_size);
+      
+      // we need the whole part, without it the server is stuck in the middle of the article
+      if (!input.read(&chunk[0], length))
+      {
+        socket.close();
+        initialize();
+        
+        throw io_exception("Unexpected end of input while posting");
+      }
+      
+      write(&encoded[0], encoder.feed(&chunk[0], length, &encoded[0], encoded.size()));
+      remaining   -=  length;
+    }
+    
+    // close the part and the article
+    write_line(encoder.footer() + ".\r\n");
+    
+    return read_lines() == 240;
+  }
+  
   // get the download speed in bytes per second on this connection
   std::size_t nntp::download_speed()
   {
@@ -213,13 +471,49 @@ namespace nntp
     return socket.upload_speed();
   }
   
+  // count the traffic in other meters as well
+  void nntp::report_to(rate_meter *download, rate_meter *upload)
+  {
+    socket.report_to(download, upload);
+  }
+  
+  // cap the download speed
+  void nntp::limit(std::size_t bytes_per_second)
+  {
+    socket.limit(bytes_per_second);
+  }
+  
+  // cap the download speed with a shared limiter
+  void nntp::draw_from(rate_limiter *limiter)
+  {
+    socket.draw_from(limiter);
+  }
+  
   // disconnect from the usenet server
   void nntp::disconnect()
   {
-    // tell the server we are disconnecting
-    process_command("QUIT\n");
+    // there is nobody to say goodbye to
+    if (!socket.is_open())
+      return;
+    
+    // tell the server we are disconnecting, it may already be gone
+    try
+    {
+      process_command("QUIT\n");
+    }
+    catch (network_exception&)
+    {
+      return;
+    }
+    catch (server_exception&)
+    {
+      // the reply made no sense, close the connection all the same
+    }
     
     // and close the connection
     socket.close();
+    
+    // whatever the server sent last is of no use anymore
+    initialize();
   }
 }
@@ -19,17 +19,41 @@
 #define NNTP_H 1
 
 
+#include <istream>
+#include <deque>
+#include <functional>
 #include "intrusive_ptr.h"
 #include "socket_wrapper.h"
+#include "line_buffer.h"
+#include "status_line.h"
 
 namespace nntp
 {
   // forward declarations
   class group;
+  namespace yenc { class stream_encoder; }
   
   // typedefs
   typedef boost::intrusive_ptr<group>    group_ptr;
   
+  /**
+   * Handler called with the response to a pipelined command
+   *
+   * @param  code    status code returned by the server
+   * @param  status  the status line, without the trailing newline
+   * @param  body    the multi-line data following it, if any; the handler may take it by swapping
+   */
+  typedef std::function<void (int code, const std::string& status, std::string& body)> response_handler;
+  
+  /**
+   * A command waiting to be sent in a pipeline
+   */
+  struct pipelined_command
+  {
+    std::string         line;       // the command, newline included
+    response_handler    handler;    // called with the response
+  };
+  
   /**
    * @class  nntp::nntp
    *
@@ -41,10 +65,11 @@ namespace nntp
   private:
     socket_wrapper  socket;         // socket connection to usenet server
     group_ptr       current_group;  // pointer to currently active group
-    char            buffer[1048576];// buffer for incoming data (15 K)
-    char            *position;      // current position in buffer
+    line_buffer     reader;         // buffer for incoming data, split into lines
+    std::deque<pipelined_command> queued; // commands waiting for flush_pipeline()
     
     void initialize();
+    void fill();
   public:
     /**
      * Default constructor
@@ -74,25 +99,110 @@ namespace nntp
      */
     bool    secureConnect(const std::string& host, const std::string& service = "nntps");
     
-        
+    
+    /**
+     * Check whether the connection to the usenet server is still open
+     *
+     * @note   A connection is closed as soon as reading or writing fails.
+     *
+     * @return connected or not
+     */
+    bool    connected();
+    
+    /**
+     * Let an io_uring engine receive for this connection, see socket_wrapper::attach()
+     *
+     * @note   Only plain connections can be attached, and only once connected.
+     *
+     * @param  engine  the engine to receive with
+     * @return whether the engine receives for this connection
+     */
+    bool    attach(uring_engine& engine);
+    
     /**
-     * Read the status code from the usenet server
+     * Record the traffic of this connection to a file, see socket_wrapper::capture()
      *
-     * @note   The actual text sent back by the server (without the trailing
-     *         newline) is in the buffer variable.
+     * @param  path    the file to write to, or empty to stop recording
+     * @return whether the file could be created
+     */
+    bool    capture(const std::string& path);
+    
+    /**
+     * Play back a capture instead of connecting to a server, see socket_wrapper::replay()
+     *
+     * @note   Like connect(), this reads the greeting. Responses are then read as usual,
+     *         commands written are dropped, and once the capture is finished reading
+     *         throws a network_exception.
+     *
+     * @param  source  the capture to play back
+     * @return whether the capture starts with a greeting
+     */
+    bool    replay(session_replay& source);
+    
+    /**
+     * Read the status line from the usenet server
+     *
+     * @param  output  string to write the status line to, without the trailing newline
      * @return status code returned by the server
      */
     int     read_lines(std::string& output);
     
     /**
-     * Read the status code from the usenet server
+     * Read the status line from the usenet server
      *
-     * @note   The actual text sent back by the server (without the trailing
-     *         newline) is in the buffer variable.
      * @return status code returned by the server
      */
     int     read_lines();
     
+    /**
+     * Read the status line from the usenet server and split it
+     *
+     * @note   The fields point into the receive buffer and are only valid
+     *         until the next read from this connection.
+     *
+     * @param  status  set to the status line
+     * @return status code returned by the server, zero when the line has none
+     */
+    int     read_status(status_line& status);
+    
+    /**
+     * Read a single line from the usenet server
+     *
+     * @note   The line points into the receive buffer and is only valid
+     *         until the next read from this connection.
+     *
+     * @param  line    pointer to set to the start of the line
+     * @param  length  set to the length of the line, without the trailing newline
+     */
+    void    read_line(const char *&line, std::size_t& length);
+    
+    /**
+     * Read the next line of a multi-line response
+     *
+     * @note   The line points into the receive buffer and is only valid
+     *         until the next read from this connection. A leading dot
+     *         added by the server is already removed.
+     *
+     * @param  line    pointer to set to the start of the line
+     * @param  length  set to the length of the line, without the trailing newline
+     * @return false when the terminating line was read instead
+     */
+    bool    read_multiline(const char *&line, std::size_t& length);
+    
+    /**
+     * Read as many complete lines of a multi-line response as are available
+     *
+     * @note   The data points into the receive buffer and is only valid
+     *         until the next read from this connection. The lines are passed
+     *         on as sent, newlines and dot-stuffing included, but without the
+     *         terminating line.
+     *
+     * @param  data    pointer to set to the start of the lines
+     * @param  length  set to the number of characters available
+     * @return false when the lines end the response
+     */
+    bool    read_multiline_block(const char *&data, std::size_t& length);
+    
     /**
      * Write a line to the usenet server
      *
@@ -107,6 +217,14 @@ namespace nntp
      */
     void    write_line(const char *line);
     
+    /**
+     * Write data to the usenet server
+     *
+     * @param  data    data to send
+     * @param  length  number of characters to send
+     */
+    void    write(const char *data, std::size_t length);
+    
     /**
      * Send a command and return the reply status
      *
@@ -143,6 +261,44 @@ namespace nntp
      */
     int     process_command(const std::string& line, const int code, std::string& result);
     
+    /**
+     * Send a command and return the split reply status
+     *
+     * @note   The fields point into the receive buffer and are only valid
+     *         until the next read from this connection.
+     *
+     * @param  line    string to write to the server
+     * @param  status  set to the status line
+     * @return return code from the server
+     */
+    int     process_command(const std::string& line, status_line& status);
+    
+    /**
+     * Queue a command to be sent in a pipeline
+     *
+     * @note   Nothing is sent until flush_pipeline() is called. Only commands
+     *         whose responses can be told apart by their status code alone
+     *         should be pipelined, like STAT, HEAD, BODY and ARTICLE.
+     *
+     * @param  line    command to send, newline included
+     * @param  handler handler to call with the response
+     */
+    void    pipeline(const std::string& line, response_handler handler);
+    
+    /**
+     * Send all queued commands, keeping several in flight at once
+     *
+     * @note   Responses arrive in the order the commands were sent and the handlers
+     *         are called in that order. A failed command, like a 430 for a missing
+     *         article, only reaches its own handler. When the connection fails, or
+     *         a handler throws, the remaining commands are dropped, the connection
+     *         is closed, as their responses would otherwise reach later commands,
+     *         and the exception is passed on.
+     *
+     * @param  depth   maximum number of commands waiting for a response
+     */
+    void    flush_pipeline(std::size_t depth = 16);
+    
     /**
      * Login to the usenet server
      *
@@ -169,6 +325,23 @@ namespace nntp
      */
     void    activate_group(group_ptr open_group);
     
+    /**
+     * Post a yenc-encoded binary, or a part of one
+     *
+     * @note   The data is read from the input in fixed-size chunks and
+     *         encoded while it is being sent, so the part is never held
+     *         in memory as a whole.
+     *
+     * @throws io_exception when the input ends before the part does, the
+     *         connection is closed as the article cannot be finished
+     *
+     * @param  headers the article headers, each line terminated by \r\n
+     * @param  input   stream holding the file to post
+     * @param  encoder encoder describing the part to post
+     * @return whether the server accepted the article
+     */
+    bool    post(const std::string& headers, std::istream& input, yenc::stream_encoder& encoder);
+    
     /**
      * Get the download speed in bytes per second
      *
@@ -183,6 +356,39 @@ namespace nntp
      */
     std::size_t upload_speed();
     
+    /**
+     * Count the traffic of this connection in other meters as well, see socket_wrapper::report_to()
+     *
+     * @param  download    meter for the incoming bytes, or NULL
+     * @param  upload      meter for the outgoing bytes, or NULL
+     */
+    void    report_to(rate_meter *download, rate_meter *upload);
+    
+    /**
+     * Cap the download speed of this connection, see socket_wrapper::limit()
+     *
+     * @param  bytes_per_second    the limit, zero for no limit
+     */
+    void    limit(std::size_t bytes_per_second);
+    
+    /**
+     * Cap the download speed with a limiter shared with other connections as well
+     *
+     * @param  limiter the limiter of the server or of all servers, or NULL
+     */
+    void    draw_from(rate_limiter *limiter);
+    
+    /**
+     * Give the receive buffer back to the shared pool while the connection is idle
+     *
+     * @note   Done after flush_pipeline() by itself. The next read takes a buffer again,
+     *         so this is only worth it when the connection will be idle for a while,
+     *         for instance when it goes back to a connection_pool.
+     *
+     * @return whether the buffer was given back, which fails while unread data is waiting
+     */
+    bool    idle();
+    
     /**
      * Disconnect from the usenet server
      *
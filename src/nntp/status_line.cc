@@ -0,0 +1,181 @@
+/**
+ * This file is part of libnntp.
+ *
+ * libnntp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnntp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <strings.h>
+#include "status_line.h"
+
+namespace nntp
+{
+  // copy the field
+  std::string response_field::str() const
+  {
+    return std::string(data, length);
+  }
+  
+  // compare the field with a string
+  bool response_field::equals(const char *text) const
+  {
+    return strlen(text) == length && memcmp(data, text, length) == 0;
+  }
+  
+  // construct an empty line
+  status_line::status_line() :
+  line(""),
+  length(0),
+  status(0),
+  count(0)
+  {}
+  
+  // split a status line
+  bool status_line::parse(const char *data, std::size_t size)
+  {
+    const char  *end  =   data + size;  // end of the line
+    const char  *next;                  // start of the next field
+    
+    line    =   data;
+    length  =   size;
+    status  =   0;
+    count   =   0;
+    
+    // exactly three digits, followed by the end of the line or a separator
+    if (size < 3 || (unsigned) (data[0] - '0') > 9 || (unsigned) (data[1] - '0') > 9 || (unsigned) (data[2] - '0') > 9 || (size > 3 && data[3] != ' ' && data[3] != '\t'))
+      return false;
+    
+    status  =   (data[0] - '0') * 100 + (data[1] - '0') * 10 + (data[2] - '0');
+    
+    for (next = data + 3; count < max_fields; ++count)
+    {
+      while (next < end && (*next == ' ' || *next == '\t'))
+        ++next;
+      
+      if (next == end)
+        break;
+      
+      fields[count].data    =   next;
+      
+      // the last field we have room for takes the rest of the line
+      if (count == max_fields - 1)
+        next    =   end;
+      else
+      {
+        while (next < end && *next != ' ' && *next != '\t')
+          ++next;
+      }
+      
+      fields[count].length  =   next - fields[count].data;
+    }
+    
+    return true;
+  }
+  
+  // get the status code
+  int status_line::code() const
+  {
+    return status;
+  }
+  
+  // get the number of fields
+  std::size_t status_line::size() const
+  {
+    return count;
+  }
+  
+  // get a field following the code
+  response_field status_line::operator[](std::size_t index) const
+  {
+    response_field  empty   =   { line + length, 0 };
+    
+    return index < count ? fields[index] : empty;
+  }
+  
+  // read a field as a number
+  bool status_line::number(std::size_t index, long& value) const
+  {
+    if (index >= count)
+      return false;
+    
+    const char  *digit  =   fields[index].data;             // the digit to add
+    const char  *end    =   digit + fields[index].length;   // end of the field
+    bool        minus   =   *digit == '-';                  // whether the number is negative
+    
+    if (minus)
+      ++digit;
+    
+    if (digit == end)
+      return false;
+    
+    for (value = 0; digit < end; ++digit)
+    {
+      if ((unsigned) (*digit - '0') > 9)
+        return false;
+      
+      value   =   value * 10 + (*digit - '0');
+    }
+    
+    if (minus)
+      value   =   -value;
+    
+    return true;
+  }
+  
+  // get everything following the code
+  response_field status_line::text() const
+  {
+    response_field  message;    // the text after the code
+    
+    if (count == 0)
+      return (*this)[0];
+    
+    message.data    =   fields[0].data;
+    message.length  =   line + length - fields[0].data;
+    
+    return message;
+  }
+  
+  // get the whole line
+  response_field status_line::whole() const
+  {
+    response_field  all =   { line, length };
+    
+    return all;
+  }
+  
+  // whether the response to a command is followed by multi-line data
+  bool has_multiline_data(int code, const char *command)
+  {
+    switch (code)
+    {
+      case 100:   // help text
+      case 101:   // capability list
+      case 215:   // information follows, for the list commands
+      case 220:   // article follows
+      case 221:   // headers follow, also for xhdr
+      case 222:   // body follows
+      case 224:   // overview information follows
+      case 225:   // headers follow, for hdr
+      case 230:   // list of new articles follows
+      case 231:   // list of new groups follows
+      case 282:   // list of group descriptions follows, for xgtitle
+        return true;
+      case 211:   // group selected; listgroup adds the article numbers
+        return command != NULL && strncasecmp(command, "LISTGROUP", 9) == 0;
+      default:
+        return false;
+    }
+  }
+}
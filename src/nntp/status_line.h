@@ -0,0 +1,137 @@
+/**
+ * This file is part of libnntp.
+ *
+ * libnntp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnntp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STATUS_LINE_H
+#define STATUS_LINE_H 1
+
+#include <cstddef>
+#include <string>
+
+namespace nntp
+{
+  /**
+   * A piece of a status line, pointing into the line itself
+   */
+  struct response_field
+  {
+    const char  *data;    // start of the field
+    std::size_t length;   // number of characters in the field
+    
+    /**
+     * @return a copy of the field
+     */
+    std::string str() const;
+    
+    /**
+     * Compare the field with a string
+     *
+     * @param  text    the string to compare with
+     * @return whether the field holds exactly the string
+     */
+    bool    equals(const char *text) const;
+  };
+  
+  /**
+   * @class  nntp::status_line
+   *
+   * Splits the status line of a response into its code and the fields following it, without
+   * copying or allocating: the fields point into the line, so they are only valid as long as
+   * the line is, which for a line read by nntp is until the next read from the connection.
+   * Fields are separated by spaces or tabs. Once max_fields are found, the last one holds the
+   * rest of the line, so a human readable message stays in one piece.
+   */
+  class status_line
+  {
+  public:
+    enum
+    {
+      max_fields  =   8   // fields split off after the code
+    };
+  private:
+    const char      *line;                // the whole line
+    std::size_t     length;               // length of the line
+    int             status;               // the code, zero when the line has none
+    response_field  fields[max_fields];   // the fields after the code
+    std::size_t     count;                // number of fields found
+  public:
+    /**
+     * Constructor, for an empty line
+     */
+    status_line();
+    
+    /**
+     * Split a status line
+     *
+     * @param  data    the line, without the trailing newline
+     * @param  size    length of the line
+     * @return false when the line does not start with a three digit code
+     */
+    bool    parse(const char *data, std::size_t size);
+    
+    /**
+     * @return the status code, zero when the line has none
+     */
+    int     code() const;
+    
+    /**
+     * @return the number of fields following the code
+     */
+    std::size_t size() const;
+    
+    /**
+     * Get a field following the code
+     *
+     * @param  index   number of the field, starting at zero
+     * @return the field, empty when there are not that many
+     */
+    response_field  operator[](std::size_t index) const;
+    
+    /**
+     * Read a field as a number
+     *
+     * @param  index   number of the field, starting at zero
+     * @param  value   set to the number
+     * @return false when the field does not exist or is not a number
+     */
+    bool    number(std::size_t index, long& value) const;
+    
+    /**
+     * @return everything following the code, like the message of the server
+     */
+    response_field  text() const;
+    
+    /**
+     * @return the whole line
+     */
+    response_field  whole() const;
+  };
+  
+  /**
+   * Check whether the response to a command is followed by multi-line data
+   *
+   * @note   Follows the response codes of RFC 3977 and its extensions. Only 211
+   *         depends on the command: it has data after LISTGROUP, not after GROUP.
+   *         Without the command, 211 is taken to be a single line.
+   *
+   * @param  code    status code returned by the server
+   * @param  command the command that was answered, or NULL when unknown
+   * @return whether multi-line data follows
+   */
+  bool has_multiline_data(int code, const char *command = NULL);
+}
+
+#endif /* STATUS_LINE_H */
@@ -0,0 +1,192 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+
+#include "async_socket.h"
+
+namespace nntp
+{
+    // constructor
+    async_socket::async_socket(boost::asio::io_service& io_service, tls_context& context) :
+        io_service(io_service),
+        context(context),
+        resolver(io_service),
+        tcp_sock(NULL),
+        ssl_sock(NULL),
+        received(NULL),
+        sent(NULL)
+    {}
+
+    // destructor
+    async_socket::~async_socket()
+    {
+        close();
+
+        delete tcp_sock;
+        delete ssl_sock;
+    }
+
+    // make a connection to the usenet server
+    void async_socket::async_connect(const std::string& host, const std::string& service, bool use_ssl, connect_handler handler)
+    {
+        boost::asio::ip::tcp::resolver::query   query(host, service);   // query to resolve into endpoints
+
+        // cannot proceed if already connected
+        if (tcp_sock != NULL || ssl_sock != NULL)
+        {
+            io_service.post(std::bind(handler, boost::asio::error::already_connected));
+            return;
+        }
+
+        this->host  =   host;
+        this->port  =   service;
+
+        // allocate the socket up front, the handshake needs it later on
+        if (use_ssl)
+            ssl_sock    =   new secure(io_service, context.native());
+        else
+            tcp_sock    =   new unsecure(io_service);
+
+        resolver.async_resolve(query, [this, handler](const boost::system::error_code& error, boost::asio::ip::tcp::resolver::iterator endpoints) {
+            if (error)
+                handler(error);
+            else
+                connect_endpoints(endpoints, handler);
+        });
+    }
+
+    // try the resolved endpoints one by one
+    void async_socket::connect_endpoints(boost::asio::ip::tcp::resolver::iterator endpoints, connect_handler handler)
+    {
+        unsecure::lowest_layer_type&    socket  =   ssl_sock != NULL ? ssl_sock->lowest_layer() : tcp_sock->lowest_layer();
+
+        boost::asio::async_connect(socket, endpoints, [this, handler](const boost::system::error_code& error, boost::asio::ip::tcp::resolver::iterator) {
+            // a plain connection is done now, as is a failed one
+            if (error || ssl_sock == NULL)
+            {
+                handler(error);
+                return;
+            }
+
+            // offer a session from an earlier connection, so the handshake can be abbreviated
+            context.prepare(ssl_sock->native_handle(), host, port);
+
+            ssl_sock->async_handshake(boost::asio::ssl::stream_base::client, [this, handler](const boost::system::error_code& error) {
+                if (!error)
+                    context.completed(ssl_sock->native_handle());
+
+                handler(error);
+            });
+        });
+    }
+
+    // read some data into a buffer
+    void async_socket::async_read_some(char *buffer, std::size_t length, transfer_handler handler)
+    {
+        auto    done    =   [this, handler](const boost::system::error_code& error, std::size_t bytes) {
+            received.record(bytes);
+            handler(error, bytes);
+        };
+
+        // if we do not have a connection, we cannot read from the socket
+        if (!is_open())
+            io_service.post(std::bind(handler, boost::asio::error::not_connected, 0));
+        else if (tcp_sock != NULL)
+            tcp_sock->async_read_some(boost::asio::buffer(buffer, length), done);
+        else
+            ssl_sock->async_read_some(boost::asio::buffer(buffer, length), done);
+    }
+
+    // write all data from a buffer
+    void async_socket::async_write(const char *buffer, std::size_t length, transfer_handler handler)
+    {
+        auto    done    =   [this, handler](const boost::system::error_code& error, std::size_t bytes) {
+            sent.record(bytes);
+            handler(error, bytes);
+        };
+
+        // if we do not have a connection, we cannot write to the socket
+        if (!is_open())
+            io_service.post(std::bind(handler, boost::asio::error::not_connected, 0));
+        else if (tcp_sock != NULL)
+            boost::asio::async_write(*tcp_sock, boost::asio::buffer(buffer, length), done);
+        else
+            boost::asio::async_write(*ssl_sock, boost::asio::buffer(buffer, length), done);
+    }
+
+    // check if the socket is connected to an endpoint
+    bool async_socket::is_open()
+    {
+        return ((tcp_sock != NULL && tcp_sock->is_open())
+               || (ssl_sock != NULL && ssl_sock->lowest_layer().is_open()));
+    }
+
+    // close the connection
+    void async_socket::close()
+    {
+        boost::system::error_code   error;  // errors do not matter anymore
+
+        resolver.cancel();
+
+        // the sockets themselves stay until the destructor, pending handlers may still use them
+        if (tcp_sock != NULL)
+            tcp_sock->close(error);
+        else if (ssl_sock != NULL)
+        {
+            // we are done with the session, which keeps it resumable for the next connection
+            SSL_set_shutdown(ssl_sock->native_handle(), SSL_SENT_SHUTDOWN);
+            ssl_sock->lowest_layer().close(error);
+        }
+    }
+
+    // the service running the handlers
+    boost::asio::io_service& async_socket::service()
+    {
+        return io_service;
+    }
+
+    // number of bytes received
+    std::size_t async_socket::bytes_received()
+    {
+        return received.bytes();
+    }
+
+    // number of bytes sent
+    std::size_t async_socket::bytes_sent()
+    {
+        return sent.bytes();
+    }
+
+    // bytes received per second
+    std::size_t async_socket::download_speed()
+    {
+        return received.rate();
+    }
+
+    // bytes sent per second
+    std::size_t async_socket::upload_speed()
+    {
+        return sent.rate();
+    }
+
+    // count the traffic in other meters as well
+    void async_socket::report_to(rate_meter *download, rate_meter *upload)
+    {
+        received.report_to(download);
+        sent.report_to(upload);
+    }
+}
@@ -0,0 +1,160 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+
+#ifndef ASYNC_SOCKET_H
+#define ASYNC_SOCKET_H 1
+
+#include <string>
+#include <functional>
+#include <atomic>
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+
+#include "socket_wrapper.h"
+#include "tls_context.h"
+
+namespace nntp
+{
+    /**
+      * Called when a connection is made, or could not be made
+      */
+    typedef std::function<void (const boost::system::error_code&)> connect_handler;
+
+    /**
+      * Called when a read or write finished, with the number of bytes transferred
+      */
+    typedef std::function<void (const boost::system::error_code&, std::size_t)> transfer_handler;
+
+    /**
+      * @class  nntp::async_socket
+      *
+      * The asynchronous counterpart of socket_wrapper: a plain or tls connection on a shared
+      * io_service, where every operation returns immediately and reports to a handler. The
+      * owner has to keep the socket alive until all handlers ran.
+      */
+    class async_socket
+    {
+        private:
+            boost::asio::io_service&        io_service; // the service running our handlers
+            tls_context&                    context;    // tls settings and sessions for secure connections
+            std::string                     host;       // the server we connect to
+            std::string                     port;       // the service we connect to
+            boost::asio::ip::tcp::resolver  resolver;   // resolves the host name
+            unsecure                        *tcp_sock;  // unsecure socket connection to usenet server
+            secure                          *ssl_sock;  // secure socket connection to usenet server
+            rate_meter                      received;   // measures the bytes received
+            rate_meter                      sent;       // measures the bytes sent
+
+            async_socket(const async_socket&);
+            async_socket& operator=(const async_socket&);
+
+            /**
+              * Try the resolved endpoints one by one
+              *
+              * @param  endpoints   the endpoints to try
+              * @param  handler     handler to call when done
+              */
+            void connect_endpoints(boost::asio::ip::tcp::resolver::iterator endpoints, connect_handler handler);
+        public:
+            /**
+              * Constructor
+              *
+              * @param  io_service  the service to run the handlers on
+              * @param  context     tls settings for secure connections
+              */
+            async_socket(boost::asio::io_service& io_service, tls_context& context);
+
+            /**
+              * Destructor
+              */
+            ~async_socket();
+
+            /**
+              * Make a connection to the usenet server, doing the tls handshake if needed
+              *
+              * @param  host    hostname
+              * @param  service service name or port
+              * @param  use_ssl whether to make a secure connection
+              * @param  handler handler to call when connected
+              */
+            void async_connect(const std::string& host, const std::string& service, bool use_ssl, connect_handler handler);
+
+            /**
+              * Read some data into a buffer
+              *
+              * @param  buffer  buffer to read data into, kept alive by the caller
+              * @param  length  maximum length to read
+              * @param  handler handler to call with the number of bytes read
+              */
+            void async_read_some(char *buffer, std::size_t length, transfer_handler handler);
+
+            /**
+              * Write all data from a buffer
+              *
+              * @param  buffer  buffer to write data from, kept alive by the caller
+              * @param  length  number of bytes to write
+              * @param  handler handler to call when everything was written
+              */
+            void async_write(const char *buffer, std::size_t length, transfer_handler handler);
+
+            /**
+              * @return whether the socket is connected to an endpoint
+              */
+            bool is_open();
+
+            /**
+              * Close the connection, outstanding operations finish with an error
+              */
+            void close();
+
+            /**
+              * @return the service running the handlers
+              */
+            boost::asio::io_service& service();
+
+            /**
+              * @return the number of bytes received on this socket
+              */
+            std::size_t bytes_received();
+
+            /**
+              * @return the number of bytes sent on this socket
+              */
+            std::size_t bytes_sent();
+
+            /**
+              * @return the number of bytes received per second
+              */
+            std::size_t download_speed();
+
+            /**
+              * @return the number of bytes sent per second
+              */
+            std::size_t upload_speed();
+
+            /**
+              * Count the traffic of this socket in other meters as well
+              *
+              * @param  download    meter for the incoming bytes, or NULL
+              * @param  upload      meter for the outgoing bytes, or NULL
+              */
+            void report_to(rate_meter *download, rate_meter *upload);
+    };
+}
+
+#endif /* ASYNC_SOCKET_H */
@@ -0,0 +1,84 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+
+#include "io_engine.h"
+
+namespace nntp
+{
+    // start the engine
+    io_engine::io_engine(std::size_t threads) :
+        next(0)
+    {
+        // one thread per core is enough to keep hundreds of sockets busy
+        if (threads == 0)
+            threads =   std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+
+        for (std::size_t i = 0; i < threads; ++i)
+        {
+            services.push_back(std::unique_ptr<service_type>(new service_type(1)));
+            work.push_back(std::unique_ptr<work_type>(new work_type(*services.back())));
+        }
+
+        // start the threads only when all services exist
+        for (std::size_t i = 0; i < threads; ++i)
+        {
+            service_type    *current    =   services[i].get();
+
+            this->threads.push_back(std::thread([current]() { current->run(); }));
+        }
+    }
+
+    // stop the engine
+    io_engine::~io_engine()
+    {
+        stop();
+    }
+
+    // hand out the services round-robin
+    boost::asio::io_service& io_engine::service()
+    {
+        return *services[next++ % services.size()];
+    }
+
+    // the shared tls context
+    tls_context& io_engine::tls()
+    {
+        return tls_context::shared();
+    }
+
+    // number of threads running the engine
+    std::size_t io_engine::size()
+    {
+        return services.size();
+    }
+
+    // stop all services
+    void io_engine::stop()
+    {
+        work.clear();
+
+        for (std::size_t i = 0; i < services.size(); ++i)
+            services[i]->stop();
+
+        for (std::size_t i = 0; i < threads.size(); ++i)
+        {
+            if (threads[i].joinable())
+                threads[i].join();
+        }
+    }
+}
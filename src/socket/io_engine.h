@@ -0,0 +1,98 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+
+#ifndef IO_ENGINE_H
+#define IO_ENGINE_H 1
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <boost/asio.hpp>
+
+#include "tls_context.h"
+
+namespace nntp
+{
+    /**
+      * @class  nntp::io_engine
+      *
+      * A small set of io_services, each run by its own thread, shared by all asynchronous
+      * connections. Connections are spread over the services round-robin and every handler
+      * of a connection runs on the thread of its service, so a connection never has to lock
+      * its own state. Secure connections use the process-wide tls_context, so they resume
+      * sessions of blocking connections and the other way around. The engine has to outlive
+      * all connections that use it.
+      */
+    class io_engine
+    {
+        private:
+            typedef boost::asio::io_service         service_type;
+            typedef boost::asio::io_service::work   work_type;
+
+            std::vector<std::unique_ptr<service_type> > services;   // the io_services handed out
+            std::vector<std::unique_ptr<work_type> >    work;       // keeps the services running while idle
+            std::vector<std::thread>                    threads;    // one thread per service
+            std::atomic<std::size_t>                    next;       // service to hand out next
+
+            io_engine(const io_engine&);
+            io_engine& operator=(const io_engine&);
+        public:
+            /**
+              * Start the engine
+              *
+              * @param  threads     number of threads, 0 to use one per core
+              */
+            io_engine(std::size_t threads = 0);
+
+            /**
+              * Destructor, stops the engine
+              */
+            ~io_engine();
+
+            /**
+              * Get an io_service to run a new connection on
+              *
+              * @return the least recently handed out service
+              */
+            boost::asio::io_service& service();
+
+            /**
+              * Get the tls context shared by all connections
+              *
+              * @return the context
+              */
+            tls_context& tls();
+
+            /**
+              * Get the number of threads running the engine
+              *
+              * @return the number of threads
+              */
+            std::size_t size();
+
+            /**
+              * Stop all services and wait for their threads to finish
+              *
+              * @note   Handlers that did not run yet are dropped
+              */
+            void stop();
+    };
+}
+
+#endif /* IO_ENGINE_H */
@@ -0,0 +1,188 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+
+#include "rate_limiter.h"
+#include <algorithm>
+
+namespace nntp
+{
+    // constructor
+    rate_limiter::rate_limiter(rate_limiter *parent) :
+        rate(0),
+        parent(parent),
+        tokens(0),
+        credit(0),
+        refilled(clock::now())
+    {}
+
+    // change the limit
+    void rate_limiter::limit(std::size_t bytes_per_second)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            // start from an empty bucket, so lifting and setting a limit does not allow a burst
+            rate        =   bytes_per_second;
+            tokens      =   0;
+            refilled    =   clock::now();
+        }
+
+        changed.notify_all();
+    }
+
+    // the current limit
+    std::size_t rate_limiter::limit()
+    {
+        return rate.load(std::memory_order_relaxed);
+    }
+
+    // draw from another limiter as well
+    void rate_limiter::draw_from(rate_limiter *parent)
+    {
+        this->parent.store(parent, std::memory_order_release);
+    }
+
+    // take bytes from our own bucket
+    std::size_t rate_limiter::take(std::size_t wanted)
+    {
+        std::unique_lock<std::mutex>    lock(mutex);
+
+        while (true)
+        {
+            std::size_t         current =   rate.load(std::memory_order_relaxed);   // the limit right now
+            clock::time_point   now     =   clock::now();
+
+            // the limit was lifted while we waited
+            if (current == 0)
+                return wanted;
+
+            // a tenth of a second of tokens can be saved up, so reads do not get too small
+            double  burst   =   std::max<double>(current / 10, least_burst);
+            double  needed  =   std::min<double>(wanted, burst);
+
+            tokens      =   std::min(burst, tokens + std::chrono::duration<double>(now - refilled).count() * current);
+            refilled    =   now;
+
+            if (tokens >= needed)
+            {
+                std::size_t granted =   (std::size_t) std::min<double>(wanted, tokens);
+
+                tokens  -=  granted;
+                return granted;
+            }
+
+            // sleep until the bucket holds enough, or the limit changes
+            changed.wait_for(lock, std::chrono::duration<double>((needed - tokens) / current));
+        }
+    }
+
+    // take bytes from the credit granted by the parent
+    std::size_t rate_limiter::draw(std::size_t wanted, rate_limiter *source)
+    {
+        std::unique_lock<std::mutex>    lock(mutex);
+
+        // go to the parent only when we used up the previous batch
+        if (credit == 0)
+        {
+            lock.unlock();
+
+            std::size_t batch   =   source->acquire(std::max<std::size_t>(wanted, batch_size));
+
+            lock.lock();
+            credit  +=  batch;
+        }
+
+        std::size_t granted =   std::min(wanted, credit);
+
+        credit  -=  granted;
+
+        return granted;
+    }
+
+    // whether no limit applies anywhere up the tree
+    bool rate_limiter::unlimited()
+    {
+        for (rate_limiter *level = this; level != NULL; level = level->parent.load(std::memory_order_acquire))
+            if (level->rate.load(std::memory_order_relaxed) != 0)
+                return false;
+
+        return true;
+    }
+
+    // get permission to transfer data
+    std::size_t rate_limiter::acquire(std::size_t wanted)
+    {
+        rate_limiter    *source     =   parent.load(std::memory_order_acquire); // the limiter above us
+        std::size_t     granted     =   wanted;                                 // what we may transfer
+
+        // nothing to limit, the usual case
+        if (unlimited())
+            return wanted;
+
+        if (rate.load(std::memory_order_relaxed) != 0)
+            granted =   take(granted);
+
+        // the levels above may allow less than we do
+        if (source != NULL)
+        {
+            std::size_t allowed =   draw(granted, source);
+
+            if (allowed < granted)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                tokens  +=  granted - allowed;
+            }
+
+            granted =   allowed;
+        }
+
+        return granted;
+    }
+
+    // give back what was not transferred
+    void rate_limiter::refund(std::size_t unused)
+    {
+        bool    limited =   rate.load(std::memory_order_relaxed) != 0;              // whether we took from our own bucket
+        bool    drawn   =   parent.load(std::memory_order_relaxed) != NULL;         // whether we took from the parent
+
+        // nothing was taken, the usual case
+        if (unused == 0 || unlimited())
+            return;
+
+        std::size_t     excess  =   0;  // credit beyond a batch, which goes back up
+        rate_limiter    *source =   parent.load(std::memory_order_relaxed);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (limited)
+                tokens  +=  unused;
+
+            // keep no more than a batch, the other connections may need the rest
+            if (drawn && (credit += unused) > batch_size)
+            {
+                excess  =   credit - batch_size;
+                credit  =   batch_size;
+            }
+        }
+
+        if (excess > 0 && source != NULL)
+            source->refund(excess);
+    }
+}
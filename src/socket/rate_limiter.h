@@ -0,0 +1,130 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H 1
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstddef>
+
+namespace nntp
+{
+    /**
+      * @class  nntp::rate_limiter
+      *
+      * A token bucket capping a transfer speed. Limiters form a tree: a connection draws from
+      * the limiter of its server, which draws from a global one, and a transfer has to fit in
+      * every limit on the way up. Each level can be limited or not, and changed at any time.
+      *
+      * Tokens are taken from the parent in batches and kept as credit, so a shared limiter is
+      * only locked once per batch instead of once per read. While neither a limiter nor any of
+      * its parents is limited, it takes no lock and costs one atomic load per level.
+      */
+    class rate_limiter
+    {
+        private:
+            typedef std::chrono::steady_clock   clock;
+
+            enum
+            {
+                batch_size  =   16384,  // least number of bytes taken from the parent at once
+                least_burst =   4096    // least number of bytes that may be transferred at once
+            };
+
+            std::atomic<std::size_t>    rate;       // bytes per second, zero for no limit
+            std::atomic<rate_limiter *> parent;     // limiter this one draws from, if any
+            std::mutex                  mutex;      // protects the members below
+            std::condition_variable     changed;    // signalled when the limit changes
+            double                      tokens;     // bytes that may be transferred right now
+            std::size_t                 credit;     // bytes already granted by the parent
+            clock::time_point           refilled;   // when tokens were last added
+
+            rate_limiter(const rate_limiter&);
+            rate_limiter& operator=(const rate_limiter&);
+
+            /**
+              * Take bytes from our own bucket, waiting until there are enough
+              *
+              * @param  wanted  the number of bytes wanted
+              * @return the number of bytes granted, at least one
+              */
+            std::size_t take(std::size_t wanted);
+
+            /**
+              * Take bytes from the credit granted by the parent, drawing a new batch when empty
+              *
+              * @param  wanted  the number of bytes wanted
+              * @param  source  the parent to draw from
+              * @return the number of bytes granted, at least one
+              */
+            std::size_t draw(std::size_t wanted, rate_limiter *source);
+
+            /**
+              * @return whether neither this limiter nor any of its parents is limited
+              */
+            bool unlimited();
+        public:
+            /**
+              * Constructor
+              *
+              * @param  parent  the limiter to draw from as well, or NULL
+              */
+            rate_limiter(rate_limiter *parent = NULL);
+
+            /**
+              * Change the limit
+              *
+              * @note   Takes effect right away, also for transfers waiting for tokens
+              *
+              * @param  bytes_per_second    the new limit, zero for no limit
+              */
+            void limit(std::size_t bytes_per_second);
+
+            /**
+              * @return the limit in bytes per second, zero for no limit
+              */
+            std::size_t limit();
+
+            /**
+              * Draw from another limiter as well, from now on
+              *
+              * @param  parent  the limiter to draw from, or NULL to stop
+              */
+            void draw_from(rate_limiter *parent);
+
+            /**
+              * Get permission to transfer data, waiting until this and every parent allows it
+              *
+              * @param  wanted  the number of bytes we would like to transfer
+              * @return the number of bytes we may transfer, between one and wanted
+              */
+            std::size_t acquire(std::size_t wanted);
+
+            /**
+              * Give back bytes that were acquired but not transferred
+              *
+              * @param  unused  the number of bytes not transferred
+              */
+            void refund(std::size_t unused);
+    };
+}
+
+#endif /* RATE_LIMITER_H */
@@ -0,0 +1,118 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+
+#include "rate_meter.h"
+#include <algorithm>
+#include <chrono>
+
+namespace nntp
+{
+    // the slice number is kept in the top bits of a slice, the bytes in the rest
+    static const unsigned       tag_shift   =   40;
+    static const std::uint64_t  byte_mask   =   (std::uint64_t(1) << tag_shift) - 1;
+
+    // the part of a slice number stored with the bytes
+    static std::uint64_t tag(std::uint64_t slice)
+    {
+        return slice << tag_shift;
+    }
+
+    // the number of the current slice
+    std::uint64_t rate_meter::now()
+    {
+        std::chrono::steady_clock::duration elapsed =   std::chrono::steady_clock::now().time_since_epoch();
+
+        return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() / slice_length;
+    }
+
+    // constructor
+    rate_meter::rate_meter(rate_meter *parent) :
+        first(now()),
+        total(0),
+        parent(parent)
+    {
+        for (std::size_t i = 0; i < slice_count; ++i)
+            slices[i]   =   0;
+    }
+
+    // count transferred bytes
+    void rate_meter::record(std::size_t bytes)
+    {
+        std::uint64_t               slice   =   now();                          // the current slice
+        std::atomic<std::uint64_t>& target  =   slices[slice % slice_count];    // where it is kept
+        std::uint64_t               current =   target.load(std::memory_order_relaxed);
+        std::uint64_t               updated;                                    // what we replace it with
+
+        // add to the slice, or start it over when it still holds an old one
+        do
+        {
+            if ((current & ~byte_mask) == tag(slice))
+                updated =   current + bytes;
+            else
+                updated =   tag(slice) | bytes;
+        }
+        while (!target.compare_exchange_weak(current, updated, std::memory_order_relaxed));
+
+        total.fetch_add(bytes, std::memory_order_relaxed);
+
+        if (rate_meter *target = parent.load(std::memory_order_acquire))
+            target->record(bytes);
+    }
+
+    // pass everything on to another meter
+    void rate_meter::report_to(rate_meter *parent)
+    {
+        this->parent.store(parent, std::memory_order_release);
+    }
+
+    // start measuring anew
+    void rate_meter::clear()
+    {
+        first.store(now(), std::memory_order_relaxed);
+    }
+
+    // speed over the last three seconds
+    std::size_t rate_meter::rate()
+    {
+        std::uint64_t   slice   =   now();                                      // the current slice, not complete yet
+        std::uint64_t   start   =   first.load(std::memory_order_relaxed);      // slices before this do not count
+        std::uint64_t   count   =   std::min<std::uint64_t>(slice - start, window); // completed slices to count
+        std::uint64_t   bytes   =   0;                                          // bytes in those slices
+
+        // nothing is complete yet right after starting
+        if (count == 0)
+            return 0;
+
+        // slices without traffic still hold an older slice number and are skipped
+        for (std::uint64_t i = slice - count; i < slice; ++i)
+        {
+            std::uint64_t   value   =   slices[i % slice_count].load(std::memory_order_relaxed);
+
+            if ((value & ~byte_mask) == tag(i))
+                bytes   +=  value & byte_mask;
+        }
+
+        return (std::size_t) (bytes * (1000 / slice_length) / count);
+    }
+
+    // everything counted
+    std::uint64_t rate_meter::bytes()
+    {
+        return total.load(std::memory_order_relaxed);
+    }
+}
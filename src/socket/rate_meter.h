@@ -0,0 +1,108 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+
+#ifndef RATE_METER_H
+#define RATE_METER_H 1
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace nntp
+{
+    /**
+      * @class  nntp::rate_meter
+      *
+      * Measures a transfer speed over the last three seconds, in slices of a tenth of a
+      * second kept in a fixed ring. Each slice is a single atomic word holding both the
+      * number of the slice and the bytes counted in it, so counting takes one compare and
+      * swap and the speed can be read from any thread without a lock. Time comes from the
+      * monotonic clock, so changing the system time does not disturb the measurement.
+      *
+      * A meter can pass everything it counts on to a parent, so the meters of all connections
+      * to a server add up in the meter of that server, and those of all servers in a global
+      * one. Reading the total then costs the same as reading a single connection.
+      */
+    class rate_meter
+    {
+        private:
+            enum
+            {
+                slice_count     =   32,     // slices in the ring, a few more than the window
+                window          =   30,     // completed slices the speed is measured over
+                slice_length    =   100     // length of a slice in milliseconds
+            };
+
+            std::atomic<std::uint64_t>  slices[slice_count];    // slice number in the top bits, bytes below
+            std::atomic<std::uint64_t>  first;                  // the slice the measurement started in
+            std::atomic<std::uint64_t>  total;                  // bytes counted since construction
+            std::atomic<rate_meter *>   parent;                 // meter that counts everything again, if any
+
+            rate_meter(const rate_meter&);
+            rate_meter& operator=(const rate_meter&);
+
+            /**
+              * @return the number of the current slice
+              */
+            static std::uint64_t now();
+        public:
+            /**
+              * Constructor
+              *
+              * @param  parent  meter that counts everything this one counts, or NULL
+              */
+            rate_meter(rate_meter *parent = NULL);
+
+            /**
+              * Pass everything counted from now on to another meter as well
+              *
+              * @param  parent  the meter to pass it to, or NULL to stop
+              */
+            void report_to(rate_meter *parent);
+
+            /**
+              * Count transferred bytes
+              *
+              * @param  bytes   number of bytes transferred just now
+              */
+            void record(std::size_t bytes);
+
+            /**
+              * Start measuring anew, for instance after a reconnect
+              *
+              * @note   The parent keeps what it counted
+              */
+            void clear();
+
+            /**
+              * Get the speed over the last three seconds, or less if the measurement started later
+              *
+              * @return the speed in bytes per second
+              */
+            std::size_t rate();
+
+            /**
+              * Get everything counted since the meter was made
+              *
+              * @return the number of bytes
+              */
+            std::uint64_t bytes();
+    };
+}
+
+#endif /* RATE_METER_H */
@@ -0,0 +1,103 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#include "session_capture.h"
+
+namespace nntp
+{
+    // the first bytes of every capture, with a version number at the end
+    const char session_capture::signature[8] = { 'N', 'N', 'T', 'P', 'C', 'A', 'P', 1 };
+
+    // constructor
+    session_capture::session_capture() :
+        file(NULL)
+    {}
+
+    // destructor
+    session_capture::~session_capture()
+    {
+        close();
+    }
+
+    // write a number as a base-128 varint
+    void session_capture::write_number(std::uint64_t value)
+    {
+        // seven bits at a time, the high bit tells whether more follow
+        while (value >= 0x80)
+        {
+            putc((int) (value & 0x7f) | 0x80, file);
+            value >>= 7;
+        }
+
+        putc((int) value, file);
+    }
+
+    // start a capture
+    bool session_capture::open(const std::string& path)
+    {
+        // finish a previous capture first
+        close();
+
+        file    =   fopen(path.c_str(), "wb");
+
+        if (file == NULL)
+            return false;
+
+        // records are small, so let them pile up before they go to disk
+        buffer.reset(new char[1048576]);
+        setvbuf(file, buffer.get(), _IOFBF, 1048576);
+
+        fwrite(signature, 1, sizeof(signature), file);
+
+        // the first record is timed from the start of the capture
+        last    =   std::chrono::steady_clock::now();
+
+        return true;
+    }
+
+    // check whether a capture is being written
+    bool session_capture::is_open()
+    {
+        return file != NULL;
+    }
+
+    // add data to the capture
+    void session_capture::record(direction way, const char *data, std::size_t length)
+    {
+        std::chrono::steady_clock::time_point   now =   std::chrono::steady_clock::now();
+
+        if (file == NULL || length == 0)
+            return;
+
+        write_number(std::chrono::duration_cast<std::chrono::microseconds>(now - last).count());
+        write_number(((std::uint64_t) length << 1) | way);
+        fwrite(data, 1, length, file);
+
+        last    =   now;
+    }
+
+    // finish the capture
+    void session_capture::close()
+    {
+        if (file == NULL)
+            return;
+
+        fclose(file);
+        file    =   NULL;
+        buffer.reset();
+    }
+}
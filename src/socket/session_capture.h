@@ -0,0 +1,106 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef SESSION_CAPTURE_H
+#define SESSION_CAPTURE_H 1
+
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <memory>
+#include <chrono>
+
+namespace nntp
+{
+    /**
+      * @class  nntp::session_capture
+      *
+      * Records the traffic of a connection to a file, after decryption, so it can be fed
+      * through the parser and the decoder again later with a session_replay. The file
+      * starts with an eight byte signature, followed by one record per read or write: the
+      * microseconds since the previous record, the length shifted left by one with the
+      * direction in the lowest bit, both as base-128 varints, and then the data itself.
+      */
+    class session_capture
+    {
+        public:
+            /**
+              * Which way the recorded data went
+              */
+            enum direction
+            {
+                incoming    =   0,  // received from the server
+                outgoing    =   1   // sent to the server
+            };
+
+            static const char   signature[8];   // the first bytes of every capture
+        private:
+            FILE                                    *file;      // the capture being written
+            std::unique_ptr<char[]>                 buffer;     // buffer for the file, so records are written in large blocks
+            std::chrono::steady_clock::time_point   last;       // time of the previous record
+
+            session_capture(const session_capture&);
+            session_capture& operator=(const session_capture&);
+
+            /**
+              * Write a number as a base-128 varint
+              *
+              * @param  value   the number to write
+              */
+            void write_number(std::uint64_t value);
+        public:
+            /**
+              * Constructor
+              */
+            session_capture();
+
+            /**
+              * Destructor, finishes the capture
+              */
+            ~session_capture();
+
+            /**
+              * Start a capture, replacing any existing file
+              *
+              * @param  path    the file to write to
+              * @return whether the file could be created
+              */
+            bool open(const std::string& path);
+
+            /**
+              * @return whether a capture is being written
+              */
+            bool is_open();
+
+            /**
+              * Add data to the capture
+              *
+              * @param  way     whether the data was received or sent
+              * @param  data    the data, decrypted
+              * @param  length  number of bytes
+              */
+            void record(direction way, const char *data, std::size_t length);
+
+            /**
+              * Finish the capture and close the file
+              */
+            void close();
+    };
+}
+
+#endif /* SESSION_CAPTURE_H */
@@ -0,0 +1,176 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#include "session_replay.h"
+#include "session_capture.h"
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <cstring>
+
+namespace nntp
+{
+    // read a base-128 varint, false when the data ends first
+    static bool read_number(const char *&data, const char *end, std::uint64_t& value)
+    {
+        value   =   0;
+
+        for (unsigned shift = 0; data < end && shift < 64; shift += 7)
+        {
+            unsigned char   byte    =   *data++;
+
+            value   |=  (std::uint64_t) (byte & 0x7f) << shift;
+
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    // constructor
+    session_replay::session_replay() :
+        sent(0),
+        next(0),
+        position(0),
+        paced(false),
+        started(false)
+    {}
+
+    // load a capture
+    bool session_replay::load(const std::string& path)
+    {
+        std::ifstream   input(path.c_str(), std::ios::binary);  // the capture
+        std::string     capture;                                // all of it
+        std::uint64_t   time    =   0;                          // time of the current record
+
+        if (!input)
+            return false;
+
+        capture.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+
+        if (capture.size() < sizeof(session_capture::signature) || memcmp(capture.data(), session_capture::signature, sizeof(session_capture::signature)) != 0)
+            return false;
+
+        received.clear();
+        pieces.clear();
+        sent    =   0;
+
+        const char  *data   =   capture.data() + sizeof(session_capture::signature);
+        const char  *end    =   capture.data() + capture.size();
+
+        while (data < end)
+        {
+            std::uint64_t   delay;  // time since the previous record
+            std::uint64_t   header; // length and direction
+
+            // stop at a record that was cut off
+            if (!read_number(data, end, delay) || !read_number(data, end, header) || (std::uint64_t) (end - data) < (header >> 1))
+                break;
+
+            time    +=  delay;
+
+            if ((header & 1) == session_capture::outgoing)
+                sent    +=  header >> 1;
+            // an empty piece would read like the end of the capture
+            else if ((header >> 1) > 0)
+            {
+                piece   received_piece  =   { time, received.size(), (std::size_t) (header >> 1) };
+
+                pieces.push_back(received_piece);
+                received.append(data, received_piece.length);
+            }
+
+            data    +=  header >> 1;
+        }
+
+        rewind();
+
+        return true;
+    }
+
+    // keep the original timing or not
+    void session_replay::pace(bool recorded)
+    {
+        paced   =   recorded;
+    }
+
+    // start over
+    void session_replay::rewind()
+    {
+        next        =   0;
+        position    =   0;
+        started     =   false;
+    }
+
+    // read received data
+    std::size_t session_replay::read(char *buffer, std::size_t length)
+    {
+        if (next == pieces.size())
+            return 0;
+
+        // the clock starts with the first read, which is where the original session connected
+        if (!started)
+        {
+            start   =   std::chrono::steady_clock::now();
+            started =   true;
+        }
+
+        const piece&    current =   pieces[next];   // the piece to read from
+
+        if (paced && position == 0)
+            std::this_thread::sleep_until(start + std::chrono::microseconds(current.time));
+
+        length  =   std::min(length, current.length - position);
+
+        memcpy(buffer, received.data() + current.offset + position, length);
+        position    +=  length;
+
+        // on to the next piece once this one is read
+        if (position == current.length)
+        {
+            ++next;
+            position    =   0;
+        }
+
+        return length;
+    }
+
+    // check whether all received data was read
+    bool session_replay::finished()
+    {
+        return next == pieces.size();
+    }
+
+    // get the number of bytes received
+    std::uint64_t session_replay::size()
+    {
+        return received.size();
+    }
+
+    // get the number of bytes sent
+    std::uint64_t session_replay::requested()
+    {
+        return sent;
+    }
+
+    // get the length of the capture
+    std::uint64_t session_replay::duration()
+    {
+        return pieces.empty() ? 0 : pieces.back().time;
+    }
+}
@@ -0,0 +1,126 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef SESSION_REPLAY_H
+#define SESSION_REPLAY_H 1
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <chrono>
+
+namespace nntp
+{
+    /**
+      * @class  nntp::session_replay
+      *
+      * Plays back a capture made with session_capture. The whole capture is loaded up front,
+      * so reading from disk does not show up in measurements. The received data is handed out
+      * in the pieces it was read in originally, so lines split across reads are split the same
+      * way again, and if pacing is enabled no piece is handed out before the time it arrived
+      * in the original session. Without pacing the data comes as fast as it is read.
+      *
+      * Attach it to a connection with socket_wrapper::replay() or nntp::replay().
+      */
+    class session_replay
+    {
+        private:
+            /**
+              * Data received in a single read
+              */
+            struct piece
+            {
+                std::uint64_t   time;   // microseconds since the start of the capture
+                std::size_t     offset; // start of the data in received
+                std::size_t     length; // number of bytes
+            };
+
+            std::string                             received;   // everything received, in order
+            std::vector<piece>                      pieces;     // the reads it was received in
+            std::uint64_t                           sent;       // number of bytes sent in the original session
+            std::size_t                             next;       // the piece to read from
+            std::size_t                             position;   // bytes of the piece already read
+            bool                                    paced;      // whether to keep the original timing
+            bool                                    started;    // whether the playback started
+            std::chrono::steady_clock::time_point   start;      // when the playback started
+
+            session_replay(const session_replay&);
+            session_replay& operator=(const session_replay&);
+        public:
+            /**
+              * Constructor
+              */
+            session_replay();
+
+            /**
+              * Load a capture, replacing the one loaded before
+              *
+              * @note   A capture that was cut off, for instance because the program was killed,
+              *         is loaded up to the last complete record
+              *
+              * @param  path    the file made by session_capture
+              * @return whether the file could be read and is a capture
+              */
+            bool load(const std::string& path);
+
+            /**
+              * Keep the timing of the original session, or play back as fast as possible
+              *
+              * @param  recorded    whether to wait for the original arrival time of the data
+              */
+            void pace(bool recorded);
+
+            /**
+              * Start over at the beginning of the capture
+              */
+            void rewind();
+
+            /**
+              * Read received data
+              *
+              * @note   At most one piece is returned per read, like the original read
+              *
+              * @param  buffer  buffer to read data into
+              * @param  length  maximum length to read
+              * @return number of bytes read, zero when the capture is finished
+              */
+            std::size_t read(char *buffer, std::size_t length);
+
+            /**
+              * @return whether all received data was read
+              */
+            bool finished();
+
+            /**
+              * @return the number of bytes received in the capture
+              */
+            std::uint64_t size();
+
+            /**
+              * @return the number of bytes sent in the capture
+              */
+            std::uint64_t requested();
+
+            /**
+              * @return the length of the capture in microseconds, up to the last data received
+              */
+            std::uint64_t duration();
+    };
+}
+
+#endif /* SESSION_REPLAY_H */
@@ -16,15 +16,52 @@
   */
 
 #include "socket_wrapper.h"
+#include "tls_context.h"
+#include "uring_engine.h"
+#include "session_replay.h"
+#include <climits>
+#include <deque>
+#include <cstring>
 
 namespace nntp
 {
+    // turn the outcome of SSL_read or SSL_write into a byte count and an error
+    static std::size_t ssl_result(int result, boost::system::error_code& error)
+    {
+        if (result > 0)
+            return result;
+
+        // closed by the server or broken, either way the connection is gone
+        error   =   boost::asio::error::connection_reset;
+        return 0;
+    }
+
+    // a buffer of an io_uring engine, holding received data
+    struct received_buffer
+    {
+        std::uint16_t               id;         // the buffer, to give it back
+        const char                  *data;      // the received data
+        std::size_t                 length;     // number of bytes received
+    };
+
+    // data received by an io_uring engine, waiting to be read
+    struct socket_wrapper::received_data
+    {
+        std::mutex                  mutex;      // protects the members below
+        std::condition_variable     arrived;    // signalled when data arrives or the socket closes
+        std::deque<received_buffer> pending;    // the buffers holding the data, oldest first
+        std::size_t                 offset;     // how much of the oldest buffer was already read
+        bool                        closed;     // whether the socket was closed
+        int                         error;      // errno when the socket broke, zero when closed normally
+    };
+
     // constructor
     socket_wrapper::socket_wrapper() :
         tcp_sock(NULL),
         ssl_sock(NULL),
-        inc_bytes(0),
-        out_bytes(0)
+        kernel_ssl(NULL),
+        uring(NULL),
+        playback(NULL)
     {}
 
     // constructor
@@ -33,69 +70,22 @@ namespace nntp
         close();
     }
 
-    // update slices
-    void socket_wrapper::update_slices()
-    {
-        // check if a tenth of a second has passed since the last switch
-        while (boost::posix_time::microsec_clock::universal_time() >= slice_time)
-        {
-            // add the current slices to the totals
-            inc_bytes   +=  slice_inc;
-            out_bytes   +=  slice_out;
-
-            // do we already have the required amount of slices
-            if (incoming.size() == 30)
-            {
-                // subtract the old amount from the totals
-                inc_bytes   -=  incoming.front();
-                out_bytes   -=  outgoing.front();
-
-                // and remove it from the queue
-                incoming.pop();
-                outgoing.pop();
-            }
-
-            // push them into our queue
-            incoming.push(slice_inc);
-            outgoing.push(slice_out);
-
-            // and make them empty for the next iteration
-            slice_inc   =   0;
-            slice_out   =   0;
-
-            // set the time for the next iteration
-            slice_time  +=  boost::posix_time::millisec(100);
-        }
-    }
-
     // log input and output data
     void socket_wrapper::log_io(std::size_t received, std::size_t sent)
     {
-        // make sure slices are accurate
-        update_slices();
+        if (received > 0)
+            incoming.record(received);
 
-        // log the data
-        slice_inc   +=  received;
-        slice_out   +=  sent;
+        if (sent > 0)
+            outgoing.record(sent);
     }
 
     // clear the io log
     void socket_wrapper::clear_log()
     {
-        while (incoming.size() > 0)
-        {
-            // pop all items from the log 
-            incoming.pop();
-            outgoing.pop();
-        }
-
-        // clear the current slice
-        slice_inc   =   0;
-        slice_out   =   0;
-
-        // and clear the total byte count
-        inc_bytes   =   0;
-        out_bytes   =   0;
+        // a new connection is measured from the start
+        incoming.clear();
+        outgoing.clear();
     }
 
     // make a connection to the usenet server
@@ -108,7 +98,7 @@ namespace nntp
         boost::system::error_code                   error;                  // error returned by boost
 
         // cannot proceed if already connected
-        if (tcp_sock != NULL || ssl_sock != NULL)
+        if (tcp_sock != NULL || ssl_sock != NULL || playback != NULL)
             return false;
 
         // try to resolve to an endpoint
@@ -127,11 +117,7 @@ namespace nntp
             if (!tcp_sock->connect(*endpoint_iterator, error))
             {
                 // no data has been transmitted yet
-                incoming.push(0);
-                outgoing.push(0);
-
-                // store the current time + a tenth of a second
-                slice_time  =   boost::posix_time::microsec_clock::universal_time() + boost::posix_time::millisec(100);
+                clear_log();
 
                 // all done
                 return true;
@@ -159,13 +145,17 @@ namespace nntp
         boost::asio::ip::tcp::resolver::iterator    endpoint;                           // uninitialized endpoint 
         boost::asio::ip::tcp::resolver::query       query(host, service);               // query to resolve into endpoints
         boost::asio::ip::tcp::resolver              resolver(io_service);               // resolver to resolve the query
-        boost::asio::ssl::context                   context(io_service, ssl_context::sslv23);   // boost ssl context
+        tls_context&                                context = tls_context::shared();    // tls settings and sessions shared by all connections
         boost::system::error_code                   error;                              // error returned by boost
 
         // cannot proceed if already connected
-        if (tcp_sock != NULL || ssl_sock != NULL)
+        if (tcp_sock != NULL || ssl_sock != NULL || playback != NULL)
             return false;
 
+        // the kernel can only take over when openssl owns the socket
+        if (context.kernel_offload())
+            return connect_kernel_tls(host, service);
+
         // try to resolve to an endpoint
         endpoint_iterator   =   resolver.resolve(query, error);
 
@@ -176,26 +166,28 @@ namespace nntp
         // set ssl options and allocate a new socket
         // context.set_verify_mode(ssl_context::verify_peer);
         // context.load_verify_file("/etc/ssl/certs/ca.pem");
-        ssl_sock    =   new secure(io_service, context);
+        ssl_sock    =   new secure(io_service, context.native());
 
         // loop through the available endpoints until we can connect without an error
         while (endpoint_iterator != endpoint) {
+            // offer a session from an earlier connection, so the handshake can be abbreviated
+            context.prepare(ssl_sock->native_handle(), host, service);
+
             // try to connect to the endpoint and do a handshake
             if (!ssl_sock->lowest_layer().connect(*endpoint_iterator, error) && !ssl_sock->handshake(boost::asio::ssl::stream_base::client, error))
             {
-                // no data has been transmitted yet
-                incoming.push(0);
-                outgoing.push(0);
+                context.completed(ssl_sock->native_handle());
 
-                // store the current time + a tenth of a second
-                slice_time  =   boost::posix_time::microsec_clock::universal_time() + boost::posix_time::millisec(1000000);
+                // no data has been transmitted yet
+                clear_log();
 
                 // all done
                 return true;
             }
 
-            // and close the socket again
-            ssl_sock->lowest_layer().close();
+            // and close the socket again, a failed handshake leaves the stream unusable
+            delete ssl_sock;
+            ssl_sock    =   new secure(io_service, context.native());
 
             // increment the iterator
             ++endpoint_iterator;
@@ -209,17 +201,157 @@ namespace nntp
         return false;
     }
 
+    // make a secure connection with tls on the socket itself
+    bool socket_wrapper::connect_kernel_tls(const std::string& host, const std::string& service)
+    {
+#ifdef HAVE_KERNEL_TLS
+        tls_context&    context =   tls_context::shared();  // tls settings and sessions shared by all connections
+
+        // a plain connection first
+        if (!connect(host, service))
+            return false;
+
+        // openssl moves the record layer into the kernel after the handshake, if it can
+        kernel_ssl  =   SSL_new(context.native().native_handle());
+
+        SSL_set_options(kernel_ssl, SSL_OP_ENABLE_KTLS);
+        SSL_set_fd(kernel_ssl, tcp_sock->native_handle());
+
+        // offer a session from an earlier connection, so the handshake can be abbreviated
+        context.prepare(kernel_ssl, host, service);
+
+        if (SSL_connect(kernel_ssl) != 1)
+        {
+            close();
+            return false;
+        }
+
+        context.completed(kernel_ssl);
+
+        return true;
+#else
+        // without support we cannot even try
+        return false;
+#endif
+    }
+
     // check if the socket is connected to an endpoint
     bool socket_wrapper::is_open()
     {
         // check whether we have a socket and if it is open
         return ((tcp_sock != NULL && tcp_sock->is_open())
-               || (ssl_sock != NULL && ssl_sock->lowest_layer().is_open()));
+               || (ssl_sock != NULL && ssl_sock->lowest_layer().is_open())
+               || playback != NULL);
+    }
+
+    // check whether the kernel decrypts incoming data
+    bool socket_wrapper::kernel_tls()
+    {
+#ifdef HAVE_KERNEL_TLS
+        return kernel_ssl != NULL && BIO_get_ktls_recv(SSL_get_rbio(kernel_ssl));
+#else
+        return false;
+#endif
+    }
+
+    // let an io_uring engine receive for the connection
+    bool socket_wrapper::attach(uring_engine& engine)
+    {
+        received_data   *target;    // where the engine puts the data
+
+        // encrypted data has to go through openssl, and we only attach once
+        if (tcp_sock == NULL || kernel_ssl != NULL || received)
+            return false;
+
+        received.reset(new received_data);
+        received->offset    =   0;
+        received->closed    =   false;
+        received->error     =   0;
+        target              =   received.get();
+
+        // the handler runs on the thread of the engine
+        if (!engine.watch(tcp_sock->native_handle(), [target](std::uint16_t id, const char *data, std::size_t length, int error) {
+            std::lock_guard<std::mutex> lock(target->mutex);
+
+            // the buffer is ours until we read it, the data is not copied
+            if (length > 0)
+            {
+                received_buffer buffer  =   { id, data, length };
+
+                target->pending.push_back(buffer);
+            }
+            else
+            {
+                target->closed  =   true;
+                target->error   =   error;
+            }
+
+            target->arrived.notify_one();
+        }))
+        {
+            received.reset();
+            return false;
+        }
+
+        uring   =   &engine;
+
+        return true;
+    }
+
+    // record the traffic to a file
+    bool socket_wrapper::capture(const std::string& path)
+    {
+        if (path.empty())
+        {
+            recorder.close();
+            return true;
+        }
+
+        return recorder.open(path);
+    }
+
+    // play back a capture instead of connecting
+    bool socket_wrapper::replay(session_replay& source)
+    {
+        if (is_open())
+            return false;
+
+        playback    =   &source;
+
+        // the capture is measured like a new connection
+        clear_log();
+
+        return true;
     }
 
     // close the connection
     void socket_wrapper::close()
     {
+        // a capture played back is simply let go
+        playback    =   NULL;
+
+        // the engine has to stop receiving before the socket goes away
+        if (uring != NULL)
+        {
+            uring->unwatch(tcp_sock->native_handle());
+
+            // the handler is done, so what it left unread can go back
+            for (std::size_t i = 0; i < received->pending.size(); ++i)
+                uring->release(received->pending[i].id);
+
+            uring   =   NULL;
+            received.reset();
+        }
+
+        // tls on the socket itself goes first, it still uses the socket
+        if (kernel_ssl != NULL)
+        {
+            // we are done with the session, which keeps it resumable for the next connection
+            SSL_set_shutdown(kernel_ssl, SSL_SENT_SHUTDOWN);
+            SSL_free(kernel_ssl);
+            kernel_ssl  =   NULL;
+        }
+
         // do we have a normal connection
         if (tcp_sock != NULL)
         {
@@ -231,6 +363,9 @@ namespace nntp
         // or a secured one
         else if (ssl_sock != NULL)
         {
+            // we are done with the session, which keeps it resumable for the next connection
+            SSL_set_shutdown(ssl_sock->native_handle(), SSL_SENT_SHUTDOWN);
+
             // close, delete and set to null
             ssl_sock->lowest_layer().close();
             delete ssl_sock;
@@ -251,8 +386,64 @@ namespace nntp
         if (!is_open())
             throw network_exception("Unable to read from non-connected socket.");
 
+        // wait until every limit allows us to read, reading less when they allow only a little
+        std::size_t allowed =   throttle.acquire(length);   // the number of bytes we may read
+
+        length  =   allowed;
+
+        // did an io_uring engine already receive it?
+        if (received)
+        {
+            std::uint16_t   finished[16];   // buffers read completely, to give back
+            std::size_t     count   =   0;  // number of buffers read completely
+
+            {
+                std::unique_lock<std::mutex>    lock(received->mutex);
+
+                received->arrived.wait(lock, [this]() { return !received->pending.empty() || received->closed; });
+
+                // copy straight from the buffers of the engine, as many as fit
+                for (bytes = 0; bytes < length && !received->pending.empty() && count < 16; )
+                {
+                    received_buffer &oldest =   received->pending.front();
+                    std::size_t     size    =   std::min(length - bytes, oldest.length - received->offset);
+
+                    memcpy(buffer + bytes, oldest.data + received->offset, size);
+                    bytes               +=  size;
+                    received->offset    +=  size;
+
+                    if (received->offset < oldest.length)
+                        break;
+
+                    finished[count++]   =   oldest.id;
+                    received->pending.pop_front();
+                    received->offset    =   0;
+                }
+
+                // the connection closed only once everything in it was read
+                if (bytes == 0)
+                    error   =   boost::system::error_code(received->error ? received->error : ECONNRESET, boost::system::system_category());
+            }
+
+            // giving them back may start receives again, which takes the lock of the handler
+            for (std::size_t i = 0; i < count; ++i)
+                uring->release(finished[i]);
+        }
+        // are we playing back a capture?
+        else if (playback != NULL)
+        {
+            // read data, a finished capture is a closed connection
+            bytes   =   playback->read(buffer, length);
+
+            if (bytes == 0)
+                error   =   boost::asio::error::connection_reset;
+        }
+        // does openssl or the kernel decrypt the data on the socket itself?
+        else if (kernel_ssl != NULL)
+            // read data
+            bytes   =   ssl_result(SSL_read(kernel_ssl, buffer, (int) std::min<std::size_t>(length, INT_MAX)), error);
         // do we have an unsecured socket?
-        if (tcp_sock != NULL)
+        else if (tcp_sock != NULL)
             // read data
             bytes   =   tcp_sock->read_some(boost::asio::buffer(buffer, length), error);
         // or an unsecured one
@@ -260,6 +451,9 @@ namespace nntp
             // read data
             bytes   =   ssl_sock->read_some(boost::asio::buffer(buffer, length), error);
 
+        // what we did not get goes back to the limiters
+        throttle.refund(allowed - bytes);
+
         // check if we received an error
         if (error)
         {
@@ -272,13 +466,14 @@ namespace nntp
 
         // log it
         log_io(bytes, 0);
+        recorder.record(session_capture::incoming, buffer, bytes);
 
         // and return the result
         return bytes;
     }
 
     // write some data from a buffer
-    std::size_t socket_wrapper::write_some(const char *buffer)
+    std::size_t socket_wrapper::write_some(const char *buffer, std::size_t length)
     {
         boost::system::error_code   error;  // error returned by boost
         std::size_t                 bytes;  // number of bytes written
@@ -287,14 +482,21 @@ namespace nntp
         if (!is_open())
             throw network_exception("Unable to write to non-connected socket.");
 
+        // a capture played back does not need commands
+        if (playback != NULL)
+            bytes   =   length;
+        // does openssl or the kernel encrypt the data on the socket itself?
+        else if (kernel_ssl != NULL)
+            // write data
+            bytes   =   ssl_result(SSL_write(kernel_ssl, buffer, (int) std::min<std::size_t>(length, INT_MAX)), error);
         // do we have an unsecured socket?
-        if (tcp_sock != NULL)
+        else if (tcp_sock != NULL)
             // write data
-            bytes   =   tcp_sock->write_some(boost::asio::buffer(buffer,strlen(buffer)), error);
+            bytes   =   tcp_sock->write_some(boost::asio::buffer(buffer, length), error);
         // or an unsecured one
         else
             // write data
-            bytes   =   ssl_sock->write_some(boost::asio::buffer(buffer,strlen(buffer)), error);
+            bytes   =   ssl_sock->write_some(boost::asio::buffer(buffer, length), error);
 
         // check if we received an error
         if (error)
@@ -308,28 +510,92 @@ namespace nntp
 
         // log it
         log_io(0, bytes);
+        recorder.record(session_capture::outgoing, buffer, bytes);
 
         // and return the result
         return bytes;
     }
 
+    // write all data from a list of buffers
+    void socket_wrapper::write(const std::vector<boost::asio::const_buffer>& buffers)
+    {
+        boost::system::error_code   error;  // error returned by boost
+        std::size_t                 bytes;  // number of bytes written
+
+        // if we do not have a connection, we cannot wrote to the socket
+        if (!is_open())
+            throw network_exception("Unable to write to non-connected socket.");
+
+        // a capture played back does not need commands
+        if (playback != NULL)
+            bytes   =   boost::asio::buffer_size(buffers);
+        // a plain socket hands the whole list to the kernel at once
+        else if (tcp_sock != NULL && kernel_ssl == NULL)
+            bytes   =   boost::asio::write(*tcp_sock, buffers, error);
+        else
+        {
+            // ssl writes one buffer at a time, so join them to get as few records as possible
+            gather.clear();
+
+            for (std::size_t i = 0; i < buffers.size(); ++i)
+                gather.append(boost::asio::buffer_cast<const char *>(buffers[i]), boost::asio::buffer_size(buffers[i]));
+
+            // a blocking SSL_write only returns once everything is written
+            if (kernel_ssl != NULL)
+                bytes   =   gather.empty() ? 0 : ssl_result(SSL_write(kernel_ssl, gather.data(), (int) gather.size()), error);
+            else
+                bytes   =   boost::asio::write(*ssl_sock, boost::asio::buffer(gather), error);
+        }
+
+        // check if we received an error
+        if (error)
+        {
+            // mark the socket closed on our end too
+            close();
+
+            // raise an exception to indicate something went wrong
+            throw network_exception("The network connection was unexpectedly closed.");
+        }
+
+        // log it
+        log_io(0, bytes);
+
+        // the buffers were sent as one
+        if (recorder.is_open())
+        {
+            for (std::size_t i = 0; i < buffers.size(); ++i)
+                recorder.record(session_capture::outgoing, boost::asio::buffer_cast<const char *>(buffers[i]), boost::asio::buffer_size(buffers[i]));
+        }
+    }
+
     // get incoming bytes per second
     std::size_t socket_wrapper::download_speed()
     {
-        // update slices in case there hasn't been data for a while
-        update_slices();
-
-        // and calculate the speed
-        return inc_bytes * 10 / incoming.size();
+        return incoming.rate();
     }
 
     // get outgoing bytes per second
     std::size_t socket_wrapper::upload_speed()
     {
-        // update slices in case there hasn't been data for a while
-        update_slices();
+        return outgoing.rate();
+    }
+
+    // count the traffic in other meters as well
+    void socket_wrapper::report_to(rate_meter *download, rate_meter *upload)
+    {
+        incoming.report_to(download);
+        outgoing.report_to(upload);
+    }
 
-        // and calculate the speed
-        return out_bytes * 10 / outgoing.size();
+    // cap the download speed
+    void socket_wrapper::limit(std::size_t bytes_per_second)
+    {
+        throttle.limit(bytes_per_second);
+    }
+
+    // cap the download speed with a shared limiter
+    void socket_wrapper::draw_from(rate_limiter *limiter)
+    {
+        throttle.draw_from(limiter);
     }
 }
@@ -19,20 +19,26 @@
 #define SOCKET_WRAPPER_H 1
 
 #include <string>
-#include <queue>
+#include <vector>
+#include <memory>
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
-#include <boost/date_time/posix_time/posix_time.hpp>
 
 #include "exceptions.h"
+#include "rate_meter.h"
+#include "rate_limiter.h"
+#include "session_capture.h"
 
 namespace nntp
 {
+    // forward declarations
+    class uring_engine;
+    class session_replay;
+
     // typedefs
     typedef boost::asio::ip::tcp::socket        unsecure;
     typedef boost::asio::ssl::stream<unsecure>  secure;
     typedef boost::asio::ssl::context           ssl_context;
-    typedef std::queue<std::size_t>             byte_counter;
 
     /**
       * @class  nntp::socket_wrapper
@@ -44,21 +50,20 @@ namespace nntp
     class socket_wrapper
     {
         private:
+            struct received_data;
+
             unsecure                    *tcp_sock;  // unsecure socket connection to usenet server
             secure                      *ssl_sock;  // secure socket connection to usenet server
-            boost::posix_time::ptime    slice_time; // store time at which to switch to next slice
+            SSL                         *kernel_ssl;// tls run on tcp_sock directly, so the kernel can take over
             boost::asio::io_service     io_service; // io_service required by boost::asio
-            byte_counter                incoming;   // store count of incoming bytes over last x seconds
-            byte_counter                outgoing;   // store count of outgoing bytes over last x seconds
-            std::size_t                 slice_inc;  // store count of incoming bytes this slice
-            std::size_t                 slice_out;  // store count of outgoing bytes this slice
-            std::size_t                 inc_bytes;  // incoming bytes over the whole measured period
-            std::size_t                 out_bytes;  // outgoing bytes over the whole measured period
-
-            /**
-              * Switch to the next slice when the time is right
-              */
-            void update_slices();
+            rate_meter                  incoming;   // measures the incoming bytes
+            rate_meter                  outgoing;   // measures the outgoing bytes
+            rate_limiter                throttle;   // caps the incoming speed
+            std::string                 gather;     // joins buffers before they are written over ssl
+            uring_engine                *uring;     // engine receiving for this socket, if attached
+            std::unique_ptr<received_data> received;// data the engine received and we did not read yet
+            session_capture             recorder;   // records the decrypted traffic, if enabled
+            session_replay              *playback;  // capture played back instead of a connection, if any
 
             /**
               * Log input and output data
@@ -71,6 +76,15 @@ namespace nntp
               * Clear input and output log, done after connection is broken
               */
             void clear_log();
+
+            /**
+              * Make a secure connection with tls on the socket itself, for kernel tls
+              *
+              * @param  host    hostname
+              * @param  service service name or port
+              * @return connected or not
+              */
+            bool connect_kernel_tls(const std::string& host, const std::string& service);
         public:
             /**
               * Constructor
@@ -105,6 +119,52 @@ namespace nntp
               */
             bool is_open();
 
+            /**
+              * @return whether the kernel decrypts incoming data for this connection
+              */
+            bool kernel_tls();
+
+            /**
+              * Let an io_uring engine receive the data for this connection
+              *
+              * @note   Only plain connections can be attached, encrypted data has to
+              *         go through openssl. The engine receives in the background and
+              *         read_some() copies straight from its buffers, giving them back
+              *         once read, so a slow reader holds up the engine rather than
+              *         piling up memory. The engine has to outlive the connection,
+              *         which detaches when it is closed.
+              *
+              * @param  engine  the engine to receive with
+              * @return whether the engine receives for this connection
+              */
+            bool attach(uring_engine& engine);
+
+            /**
+              * Record the traffic of this connection to a file
+              *
+              * @note   Data is recorded as sent and received by us, after decryption.
+              *         The capture continues over reconnects, until it is stopped or
+              *         the socket is destroyed. Enable it before connecting to include
+              *         the greeting of the server.
+              *
+              * @param  path    the file to write to, or empty to stop recording
+              * @return whether the file could be created
+              */
+            bool capture(const std::string& path);
+
+            /**
+              * Play back a capture instead of connecting to a server
+              *
+              * @note   Reading returns the data received in the capture and writing
+              *         sends nothing, until the capture is finished and reading fails
+              *         like a broken connection. The capture has to outlive the
+              *         playback, which stops when the socket is closed.
+              *
+              * @param  source  the capture to play back
+              * @return false when the socket is already connected
+              */
+            bool replay(session_replay& source);
+
             /**
               * Close the connection
               */
@@ -127,21 +187,65 @@ namespace nntp
               * @throws network_exception
               *
               * @param  buffer  buffer to read data from
+              * @param  length  number of bytes in the buffer
               * @return number of bytes written
               */
-            std::size_t write_some(const char *buffer);
+            std::size_t write_some(const char *buffer, std::size_t length);
+
+            /**
+              * Write all data from a list of buffers
+              *
+              * @note   A plain socket writes the list with a single system call where
+              *         possible; for ssl the buffers are joined first, so they go out in
+              *         as few records as possible.
+              *
+              * @throws network_exception
+              *
+              * @param  buffers the buffers to write, in order
+              */
+            void write(const std::vector<boost::asio::const_buffer>& buffers);
 
             /**
               * Get the incoming transfer speed in bytes per second
+              *
+              * @note   Safe to call from any thread
+              *
               * @return the amount of bytes coming in per second
               */
             std::size_t download_speed();
 
             /**
               * Get the outgoing transfer speed in bytes per second
-              * @return the amount of bytes coming in per second
+              *
+              * @note   Safe to call from any thread
+              *
+              * @return the amount of bytes going out per second
               */
             std::size_t upload_speed();
+
+            /**
+              * Count the traffic of this connection in other meters as well
+              *
+              * @param  download    meter for the incoming bytes, or NULL
+              * @param  upload      meter for the outgoing bytes, or NULL
+              */
+            void report_to(rate_meter *download, rate_meter *upload);
+
+            /**
+              * Cap the download speed of this connection
+              *
+              * @note   Reading waits until the limit allows it, the connection stays open
+              *
+              * @param  bytes_per_second    the limit, zero for no limit
+              */
+            void limit(std::size_t bytes_per_second);
+
+            /**
+              * Cap the download speed with a limiter shared with other connections as well
+              *
+              * @param  limiter the limiter of the server or of all servers, or NULL
+              */
+            void draw_from(rate_limiter *limiter);
     };
 }
 
@@ -0,0 +1,155 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+
+#include "tls_context.h"
+
+namespace nntp
+{
+    // number of sessions kept per server, tls 1.3 tickets are best used only once
+    static const std::size_t max_sessions = 16;
+
+    // index of the server name stored with each connection
+    static int server_index()
+    {
+        static const int index = SSL_get_ex_new_index(0, NULL, NULL, NULL, NULL);
+
+        return index;
+    }
+
+    // set up the shared context
+    tls_context::tls_context() :
+        context(boost::asio::ssl::context::sslv23),
+        full(0),
+        abbreviated(0),
+        offload(false)
+    {
+        SSL_CTX     *native =   context.native_handle();
+
+        // nothing older than tls 1.0
+        context.set_options(boost::asio::ssl::context::default_workarounds | boost::asio::ssl::context::no_sslv2 | boost::asio::ssl::context::no_sslv3);
+
+        // we keep client sessions ourselves, keyed by server
+        SSL_CTX_set_session_cache_mode(native, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(native, new_session);
+        SSL_CTX_set_app_data(native, this);
+    }
+
+    // the context shared by the whole process
+    tls_context& tls_context::shared()
+    {
+        // never destroyed: openssl may already be cleaned up when static objects go
+        static tls_context  *instance   =   new tls_context();
+
+        return *instance;
+    }
+
+    // the underlying boost context
+    boost::asio::ssl::context& tls_context::native()
+    {
+        return context;
+    }
+
+    // prepare a connection for its handshake
+    void tls_context::prepare(SSL *ssl, const std::string& host, const std::string& service)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const std::string&          server  =   *servers.insert(host + ":" + service).first;
+        session_list&               cached  =   sessions[server];
+
+        // remember the server, for the sessions it is going to hand out
+        SSL_set_ex_data(ssl, server_index(), (void *) &server);
+
+        // tell the server who we want to talk to
+        SSL_set_tlsext_host_name(ssl, host.c_str());
+
+        if (cached.empty())
+            return;
+
+        // use every session once while we have several, keep the last one for everybody
+        SSL_set_session(ssl, cached.back());
+
+        if (cached.size() > 1)
+        {
+            SSL_SESSION_free(cached.back());
+            cached.pop_back();
+        }
+    }
+
+    // a server handed out a new session
+    int tls_context::new_session(SSL *ssl, SSL_SESSION *session)
+    {
+        tls_context         *self   =   (tls_context *) SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl));
+        const std::string   *server =   (const std::string *) SSL_get_ex_data(ssl, server_index());
+
+        // connections we did not prepare are not cached
+        if (server == NULL)
+            return 0;
+
+        std::lock_guard<std::mutex> lock(self->mutex);
+        session_list&               cached  =   self->sessions[*server];
+
+        cached.push_back(session);
+
+        // forget the oldest session when we have enough
+        if (cached.size() > max_sessions)
+        {
+            SSL_SESSION_free(cached.front());
+            cached.pop_front();
+        }
+
+        return 1;
+    }
+
+    // record the outcome of a handshake
+    void tls_context::completed(SSL *ssl)
+    {
+        if (SSL_session_reused(ssl))
+            ++abbreviated;
+        else
+            ++full;
+    }
+
+    // let blocking connections try kernel tls
+    bool tls_context::kernel_offload(bool enable)
+    {
+#ifdef HAVE_KERNEL_TLS
+        offload =   enable;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // whether blocking connections try kernel tls
+    bool tls_context::kernel_offload()
+    {
+        return offload;
+    }
+
+    // number of full handshakes
+    std::size_t tls_context::handshakes()
+    {
+        return full;
+    }
+
+    // number of resumed handshakes
+    std::size_t tls_context::resumptions()
+    {
+        return abbreviated;
+    }
+}
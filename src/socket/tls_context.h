@@ -0,0 +1,136 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+
+#ifndef TLS_CONTEXT_H
+#define TLS_CONTEXT_H 1
+
+#include <string>
+#include <map>
+#include <set>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <boost/asio/ssl.hpp>
+
+// openssl can hand the record layer to the linux kernel
+#if defined(__linux__) && defined(SSL_OP_ENABLE_KTLS)
+#define HAVE_KERNEL_TLS 1
+#endif
+
+namespace nntp
+{
+    /**
+      * @class  nntp::tls_context
+      *
+      * The tls settings shared by every secure connection in the process, together with a
+      * cache of the sessions servers handed out. A new connection to a server we talked to
+      * before offers one of those sessions, so the server can skip the full handshake. This
+      * works with session ids and tickets alike, including the tickets of tls 1.3 which only
+      * arrive after the handshake.
+      */
+    class tls_context
+    {
+        private:
+            typedef std::deque<SSL_SESSION *>                   session_list;
+
+            boost::asio::ssl::context               context;        // the openssl context
+            std::mutex                              mutex;          // protects the members below
+            std::set<std::string>                   servers;        // names of the servers we have sessions for
+            std::map<std::string, session_list>     sessions;       // resumable sessions per server, newest last
+            std::atomic<std::size_t>                full;           // number of full handshakes
+            std::atomic<std::size_t>                abbreviated;    // number of resumed handshakes
+            std::atomic<bool>                       offload;        // whether blocking connections use kernel tls
+
+            tls_context();
+            tls_context(const tls_context&);
+            tls_context& operator=(const tls_context&);
+
+            /**
+              * Called by openssl when a server hands out a new session
+              *
+              * @param  ssl     the connection the session belongs to
+              * @param  session the new session
+              * @return 1 when we keep a reference to the session
+              */
+            static int new_session(SSL *ssl, SSL_SESSION *session);
+        public:
+            /**
+              * Get the context shared by the whole process
+              *
+              * @return the shared context
+              */
+            static tls_context& shared();
+
+            /**
+              * Get the underlying boost context, to create streams with
+              *
+              * @return the boost context
+              */
+            boost::asio::ssl::context& native();
+
+            /**
+              * Prepare a connection for its handshake, offering a cached session if we have one
+              *
+              * @param  ssl     the connection
+              * @param  host    hostname, also sent to the server for name based hosting
+              * @param  service service name or port
+              */
+            void prepare(SSL *ssl, const std::string& host, const std::string& service);
+
+            /**
+              * Record the outcome of a successful handshake
+              *
+              * @param  ssl     the connection
+              */
+            void completed(SSL *ssl);
+
+            /**
+              * Let blocking connections made from now on try to use kernel tls
+              *
+              * @note   Those connections run tls on their socket directly, so openssl can
+              *         hand the record layer to the kernel after the handshake. When the
+              *         kernel or the negotiated cipher does not support it, openssl keeps
+              *         doing the work itself.
+              *
+              * @param  enable  whether to try kernel tls
+              * @return whether this build supports kernel tls at all
+              */
+            bool kernel_offload(bool enable);
+
+            /**
+              * @return whether blocking connections try to use kernel tls
+              */
+            bool kernel_offload();
+
+            /**
+              * Get the number of full handshakes done so far
+              *
+              * @return the number of handshakes
+              */
+            std::size_t handshakes();
+
+            /**
+              * Get the number of handshakes that resumed a session
+              *
+              * @return the number of handshakes
+              */
+            std::size_t resumptions();
+    };
+}
+
+#endif /* TLS_CONTEXT_H */
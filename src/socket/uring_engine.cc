@@ -0,0 +1,742 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+
+#include "uring_engine.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#ifdef HAVE_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+#endif
+
+namespace nntp
+{
+#ifdef HAVE_IO_URING
+    // what a submission was for, stored in the top byte of its user data
+    enum
+    {
+        kind_receive    =   1,  // multishot receive, the rest is the id of the socket
+        kind_write      =   2,  // file write, the rest is the write slot
+        kind_cancel     =   3,  // cancelled receive, nothing to do
+        kind_wake       =   4,  // wakes the reaping thread so it notices the engine stops
+        kind_probe      =   5   // receive checking for multishot support
+    };
+
+    // combine kind and value into user data
+    static std::uint64_t tag(std::uint64_t kind, std::uint64_t value)
+    {
+        return (kind << 56) | value;
+    }
+
+    // set up a new io_uring
+    static int io_uring_setup(unsigned entries, io_uring_params *params)
+    {
+        return (int) syscall(__NR_io_uring_setup, entries, params);
+    }
+
+    // submit entries and wait for completions
+    static int io_uring_enter(int ring, unsigned submit, unsigned wait, unsigned flags)
+    {
+        return (int) syscall(__NR_io_uring_enter, ring, submit, wait, flags, NULL, 0);
+    }
+
+    // register buffers with the ring
+    static int io_uring_register(int ring, unsigned opcode, void *arguments, unsigned count)
+    {
+        return (int) syscall(__NR_io_uring_register, ring, opcode, arguments, count);
+    }
+#endif
+
+    // start the engine
+    uring_engine::uring_engine(std::size_t entries, std::size_t buffer_count, std::size_t buffer_size, std::size_t slot_count, std::size_t slot_size) :
+        ring(-1),
+        buffer_size(buffer_size),
+        buffer_count(buffer_count),
+        slot_size(slot_size),
+        buffers(NULL),
+        slots(NULL),
+        buffer_ring(NULL),
+        buffer_tail(0),
+        buffers_free(0),
+        rearm_level(std::max<std::size_t>(buffer_count / 8, 1)),
+        starved(0),
+        sq_ring(NULL),
+        cq_ring(NULL),
+        sqes(NULL),
+        cqes(NULL),
+        sq_ring_size(0),
+        cq_ring_size(0),
+        sqes_size(0),
+        sq_entries(0),
+        queued(0),
+        next_id(0),
+        enters(0),
+        completions(0),
+        stopping(false)
+    {
+        // anything missing means we write and receive the ordinary way
+        if (!setup(entries, slot_count))
+            teardown();
+    }
+
+    // stop the engine
+    uring_engine::~uring_engine()
+    {
+        stop();
+        teardown();
+    }
+
+    // set up the ring, the buffers and the thread
+    bool uring_engine::setup(std::size_t entries, std::size_t slot_count)
+    {
+#ifdef HAVE_IO_URING
+        io_uring_params         params;     // what we ask for and what the kernel offers
+        io_uring_buf_reg        buffer_reg; // registration of the receive buffer ring
+        std::vector<iovec>      vectors;    // the write buffers to register
+        void                    *memory;    // freshly allocated memory
+
+        // the buffer ring needs a power of two, the buffer id has sixteen bits
+        if (buffer_count == 0 || (buffer_count & (buffer_count - 1)) != 0 || buffer_count > 32768 || slot_count == 0)
+            return false;
+
+        // many sockets with multishot receives need more room for completions than for submissions
+        memset(&params, 0, sizeof(params));
+        params.flags        =   IORING_SETUP_CQSIZE;
+        params.cq_entries   =   (unsigned) (entries * 8);
+
+        if ((ring = io_uring_setup((unsigned) entries, &params)) < 0)
+            return false;
+
+        // map the queues into our memory
+        sq_ring_size    =   params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size    =   params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        sqes_size       =   params.sq_entries * sizeof(io_uring_sqe);
+
+        // newer kernels map both rings in one go
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+            sq_ring_size    =   cq_ring_size    =   std::max(sq_ring_size, cq_ring_size);
+
+        if ((sq_ring = mmap(NULL, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING)) == MAP_FAILED)
+            return (sq_ring = NULL), false;
+
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+            cq_ring =   sq_ring;
+        else if ((cq_ring = mmap(NULL, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING)) == MAP_FAILED)
+            return (cq_ring = NULL), false;
+
+        if ((memory = mmap(NULL, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES)) == MAP_FAILED)
+            return false;
+
+        sqes        =   (io_uring_sqe *) memory;
+        cqes        =   (io_uring_cqe *) ((char *) cq_ring + params.cq_off.cqes);
+        sq_entries  =   params.sq_entries;
+        sq_head     =   (unsigned *) ((char *) sq_ring + params.sq_off.head);
+        sq_tail     =   (unsigned *) ((char *) sq_ring + params.sq_off.tail);
+        sq_mask     =   (unsigned *) ((char *) sq_ring + params.sq_off.ring_mask);
+        cq_head     =   (unsigned *) ((char *) cq_ring + params.cq_off.head);
+        cq_tail     =   (unsigned *) ((char *) cq_ring + params.cq_off.tail);
+        cq_mask     =   (unsigned *) ((char *) cq_ring + params.cq_off.ring_mask);
+
+        // entry i of the queue always uses submission i
+        for (unsigned i = 0; i < sq_entries; ++i)
+            ((unsigned *) ((char *) sq_ring + params.sq_off.array))[i]  =   i;
+
+        // the write buffers are registered, so the kernel does not map them for every write
+        if (posix_memalign(&memory, 4096, slot_count * slot_size) != 0)
+            return false;
+
+        slots   =   (char *) memory;
+
+        for (std::size_t i = 0; i < slot_count; ++i)
+        {
+            iovec   vector  =   { slots + i * slot_size, slot_size };
+
+            vectors.push_back(vector);
+            free_slots.push_back(slot_count - 1 - i);
+        }
+
+        writes.resize(slot_count);
+
+        if (io_uring_register(ring, IORING_REGISTER_BUFFERS, &vectors[0], (unsigned) vectors.size()) < 0)
+            return false;
+
+        // the receive buffers are handed to the kernel through a ring, linux 5.19 or newer
+        if (posix_memalign(&memory, 4096, buffer_count * buffer_size) != 0)
+            return false;
+
+        buffers =   (char *) memory;
+
+        if (posix_memalign(&buffer_ring, 4096, buffer_count * sizeof(io_uring_buf)) != 0)
+            return (buffer_ring = NULL), false;
+
+        memset(buffer_ring, 0, buffer_count * sizeof(io_uring_buf));
+        memset(&buffer_reg, 0, sizeof(buffer_reg));
+        buffer_reg.ring_addr    =   (std::uint64_t) buffer_ring;
+        buffer_reg.ring_entries =   (unsigned) buffer_count;
+        buffer_reg.bgid         =   0;
+
+        if (io_uring_register(ring, IORING_REGISTER_PBUF_RING, &buffer_reg, 1) < 0)
+            return false;
+
+        for (std::size_t i = 0; i < buffer_count; ++i)
+            recycle((std::uint16_t) i);
+
+        // linux 5.19 registers the buffer ring fine, but fails every receive we arm
+        if (!probe_multishot())
+            return false;
+
+        // everything is in place, start reaping
+        reaper  =   std::thread([this]() { run(); });
+
+        return true;
+#else
+        // without io_uring there is nothing to set up
+        return false;
+#endif
+    }
+
+    // check whether the kernel supports multishot receive
+    bool uring_engine::probe_multishot()
+    {
+#ifdef HAVE_IO_URING
+        int     pair[2];            // the sockets to receive on
+        bool    supported   =   false;  // whether the receive went on after the first byte
+        bool    more        =   true;   // whether the receive still has completions coming
+
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+            return false;
+
+        // data waits on the socket, so a working receive completes right away
+        if (::write(pair[1], "", 1) != 1)
+        {
+            ::close(pair[0]);
+            ::close(pair[1]);
+            return false;
+        }
+
+        submit([&pair](io_uring_sqe *entry) {
+            entry->opcode       =   IORING_OP_RECV;
+            entry->fd           =   pair[0];
+            entry->ioprio       =   IORING_RECV_MULTISHOT;
+            entry->flags        =   IOSQE_BUFFER_SELECT;
+            entry->buf_group    =   0;
+            entry->user_data    =   tag(kind_probe, 0);
+        });
+
+        // the first completion tells, a multishot receive then ends once the socket shuts down
+        for (bool first = true; more; first = false)
+        {
+            unsigned    head    =   *cq_head;
+
+            while (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+            {
+                if (io_uring_enter(ring, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+                {
+                    ::close(pair[0]);
+                    ::close(pair[1]);
+                    return false;
+                }
+
+                ++enters;
+            }
+
+            io_uring_cqe    *entry  =   &cqes[head & *cq_mask];
+
+            more    =   (entry->flags & IORING_CQE_F_MORE) != 0;
+
+            if (first)
+                supported   =   entry->res == 1 && more;
+
+            if (entry->flags & IORING_CQE_F_BUFFER)
+            {
+                --buffers_free;
+                recycle((std::uint16_t) (entry->flags >> IORING_CQE_BUFFER_SHIFT));
+            }
+
+            __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+
+            if (more)
+                shutdown(pair[0], SHUT_RDWR);
+        }
+
+        ::close(pair[0]);
+        ::close(pair[1]);
+
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    // release the ring and its memory
+    void uring_engine::teardown()
+    {
+#ifdef HAVE_IO_URING
+        // closing the ring cancels whatever is still pending and releases the registrations
+        if (ring >= 0)
+            ::close(ring);
+
+        if (sqes != NULL)
+            munmap(sqes, sqes_size);
+
+        if (cq_ring != NULL && cq_ring != sq_ring)
+            munmap(cq_ring, cq_ring_size);
+
+        if (sq_ring != NULL)
+            munmap(sq_ring, sq_ring_size);
+
+        free(buffer_ring);
+        free(buffers);
+        free(slots);
+#endif
+
+        ring        =   -1;
+        sqes        =   NULL;
+        cq_ring     =   NULL;
+        sq_ring     =   NULL;
+        buffer_ring =   NULL;
+        buffers     =   NULL;
+        slots       =   NULL;
+    }
+
+    // queue a submission
+    void uring_engine::submit(const std::function<void(io_uring_sqe *entry)>& fill)
+    {
+#ifdef HAVE_IO_URING
+        std::lock_guard<std::mutex> lock(submit_mutex);
+        unsigned                    tail    =   *sq_tail;   // where the entry goes
+
+        // a full queue has to go to the kernel first
+        while (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) == sq_entries)
+        {
+            int submitted   =   io_uring_enter(ring, (unsigned) queued, 0, 0);
+
+            ++enters;
+
+            if (submitted > 0)
+                queued  -=  submitted;
+        }
+
+        io_uring_sqe    *entry  =   &sqes[tail & *sq_mask];
+
+        memset(entry, 0, sizeof(io_uring_sqe));
+        fill(entry);
+
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+        ++queued;
+
+        // the reaping thread submits with its next wait, anyone else cannot wait for that
+        if (std::this_thread::get_id() != reaper.get_id())
+        {
+            int submitted   =   io_uring_enter(ring, (unsigned) queued, 0, 0);
+
+            ++enters;
+
+            if (submitted > 0)
+                queued  -=  submitted;
+        }
+#endif
+    }
+
+    // hand a receive buffer back to the kernel
+    void uring_engine::recycle(std::uint16_t id)
+    {
+#ifdef HAVE_IO_URING
+        // io_uring_buf_ring has its entries at the wrong offset in c++, so go by io_uring_buf,
+        // the kernel keeps the tail in the reserved field of the first entry
+        std::lock_guard<std::mutex> lock(buffer_mutex);
+        io_uring_buf                *entries    =   (io_uring_buf *) buffer_ring;
+        io_uring_buf                *buffer     =   &entries[buffer_tail & (buffer_count - 1)];
+
+        buffer->addr    =   (std::uint64_t) (buffers + id * buffer_size);
+        buffer->len     =   (unsigned) buffer_size;
+        buffer->bid     =   id;
+
+        // the kernel only reads the tail, we guard it from each other
+        __atomic_store_n(&entries[0].resv, ++buffer_tail, __ATOMIC_RELEASE);
+        ++buffers_free;
+#endif
+    }
+
+    // arm the multishot receive of a socket
+    void uring_engine::arm(std::uint64_t id, int fd)
+    {
+#ifdef HAVE_IO_URING
+        submit([id, fd](io_uring_sqe *entry) {
+            entry->opcode       =   IORING_OP_RECV;
+            entry->fd           =   fd;
+            entry->ioprio       =   IORING_RECV_MULTISHOT;
+            entry->flags        =   IOSQE_BUFFER_SELECT;
+            entry->buf_group    =   0;
+            entry->user_data    =   tag(kind_receive, id);
+        });
+#endif
+    }
+
+    // write the rest of a slot to its file
+    void uring_engine::write_slot_out(std::size_t index)
+    {
+#ifdef HAVE_IO_URING
+        write_slot  &slot   =   writes[index];
+        char        *data   =   slots + index * slot_size + slot.done;
+
+        submit([&slot, data, index](io_uring_sqe *entry) {
+            entry->opcode       =   IORING_OP_WRITE_FIXED;
+            entry->fd           =   slot.fd;
+            entry->addr         =   (std::uint64_t) data;
+            entry->len          =   (unsigned) (slot.length - slot.done);
+            entry->off          =   slot.offset + slot.done;
+            entry->buf_index    =   (std::uint16_t) index;
+            entry->user_data    =   tag(kind_write, index);
+        });
+#endif
+    }
+
+    // handle a single completion
+    void uring_engine::complete(std::uint64_t user_data, int result, std::uint32_t flags)
+    {
+#ifdef HAVE_IO_URING
+        std::uint64_t   value   =   user_data & ((std::uint64_t(1) << 56) - 1); // the socket id or write slot
+
+        ++completions;
+
+        switch (user_data >> 56)
+        {
+            case kind_receive:
+            {
+                std::lock_guard<std::recursive_mutex>   lock(handler_mutex);
+                auto                                    iter    =   handlers.find(value);
+
+                // the buffer goes to the socket, unless it stopped being watched in the meantime
+                if (flags & IORING_CQE_F_BUFFER)
+                {
+                    std::uint16_t   id  =   (std::uint16_t) (flags >> IORING_CQE_BUFFER_SHIFT);
+
+                    --buffers_free;
+
+                    if (iter != handlers.end() && result > 0)
+                        iter->second.handler(id, buffers + id * buffer_size, result, 0);
+                    else
+                        recycle(id);
+                }
+
+                // the receive goes on, or the socket was already forgotten
+                if ((flags & IORING_CQE_F_MORE) || iter == handlers.end())
+                    break;
+
+                // out of buffers, the receive waits until the receivers give some back
+                if (result == -ENOBUFS)
+                {
+                    iter->second.starved    =   true;
+                    ++starved;
+
+                    // unless they did so before they could see we starve
+                    if (buffers_free >= rearm_level)
+                    {
+                        iter->second.starved    =   false;
+                        --starved;
+                        arm(value, iter->second.fd);
+                    }
+                }
+                // out of completion space, start over now that there is room again
+                else if (result > 0)
+                    arm(value, iter->second.fd);
+                else
+                {
+                    // closed by the server or broken
+                    iter->second.handler(0, NULL, 0, -result);
+                    handlers.erase(iter);
+                }
+                break;
+            }
+            case kind_write:
+            {
+                write_slot  &slot   =   writes[value];
+
+                // try again when interrupted, a short write continues where it stopped
+                if (result == -EINTR || result == -EAGAIN)
+                    return write_slot_out(value);
+                else if (result > 0 && slot.done + result < slot.length)
+                {
+                    slot.done   +=  result;
+                    return write_slot_out(value);
+                }
+                else if (result <= 0 && slot.job->error == 0)
+                    slot.job->error =   result < 0 ? -result : EIO;
+
+                // this buffer is done, the caller hears once all of them are
+                std::shared_ptr<write_job>  job =   slot.job;
+
+                slot.job.reset();
+
+                if (--job->remaining == 0 && job->callback)
+                    job->callback(job->error);
+
+                std::lock_guard<std::mutex> lock(slot_mutex);
+
+                free_slots.push_back(value);
+                slot_freed.notify_all();
+                break;
+            }
+        }
+#endif
+    }
+
+    // reap completions until the engine stops
+    void uring_engine::run()
+    {
+#ifdef HAVE_IO_URING
+        while (!stopping)
+        {
+            unsigned    submit;     // entries queued by handlers of the previous batch
+            int         result;     // result of the call into the kernel
+
+            {
+                std::lock_guard<std::mutex> lock(submit_mutex);
+
+                submit  =   (unsigned) queued;
+                queued  =   0;
+            }
+
+            // one call submits our entries and waits for the next batch of completions
+            result  =   io_uring_enter(ring, submit, 1, IORING_ENTER_GETEVENTS);
+
+            ++enters;
+
+            if (result < 0 || (unsigned) result < submit)
+            {
+                std::lock_guard<std::mutex> lock(submit_mutex);
+
+                queued  +=  submit - std::max(result, 0);
+            }
+
+            // handle everything the kernel posted so far, across all sockets and files
+            unsigned    head    =   *cq_head;
+            unsigned    tail    =   __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+
+            for (; head != tail; ++head)
+            {
+                io_uring_cqe    *entry  =   &cqes[head & *cq_mask];
+
+                complete(entry->user_data, entry->res, entry->flags);
+            }
+
+            __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+        }
+#endif
+    }
+
+    // whether io_uring is used
+    bool uring_engine::available()
+    {
+        return ring >= 0;
+    }
+
+    // start receiving on a socket
+    bool uring_engine::watch(int fd, receive_handler handler)
+    {
+        std::uint64_t   id; // id of the socket
+
+        // without the ring the socket reads the ordinary way
+        if (!available())
+            return false;
+
+        {
+            std::lock_guard<std::recursive_mutex>   lock(handler_mutex);
+
+            id  =   next_id++;
+            watched_socket  &socket =   handlers[id];
+
+            socket.fd       =   fd;
+            socket.handler  =   handler;
+            socket.starved  =   false;
+        }
+
+        arm(id, fd);
+
+        return true;
+    }
+
+    // stop receiving on a socket
+    void uring_engine::unwatch(int fd)
+    {
+#ifdef HAVE_IO_URING
+        // taking the lock waits for a handler that is running right now
+        std::lock_guard<std::recursive_mutex>   lock(handler_mutex);
+
+        for (auto iter = handlers.begin(); iter != handlers.end(); ++iter)
+        {
+            if (iter->second.fd != fd)
+                continue;
+
+            std::uint64_t   target  =   tag(kind_receive, iter->first);
+
+            // a starved socket has no receive armed
+            if (iter->second.starved)
+            {
+                --starved;
+                handlers.erase(iter);
+                break;
+            }
+
+            handlers.erase(iter);
+
+            // the receive itself may still be armed, its buffers come back on completion
+            submit([target](io_uring_sqe *entry) {
+                entry->opcode       =   IORING_OP_ASYNC_CANCEL;
+                entry->fd           =   -1;
+                entry->addr         =   target;
+                entry->user_data    =   tag(kind_cancel, 0);
+            });
+            break;
+        }
+#endif
+    }
+
+    // give a receive buffer back
+    void uring_engine::release(std::uint16_t buffer)
+    {
+#ifdef HAVE_IO_URING
+        recycle(buffer);
+
+        // wait for a good part of the ring before starting starved receives, or they starve again at once
+        if (starved == 0 || buffers_free < rearm_level)
+            return;
+
+        std::lock_guard<std::recursive_mutex>   lock(handler_mutex);
+
+        for (auto iter = handlers.begin(); iter != handlers.end() && starved > 0; ++iter)
+        {
+            if (!iter->second.starved)
+                continue;
+
+            iter->second.starved    =   false;
+            --starved;
+            arm(iter->first, iter->second.fd);
+        }
+#endif
+    }
+
+    // write data to a file
+    void uring_engine::write_file(int fd, const char *data, std::size_t length, std::uint64_t offset, write_callback callback)
+    {
+        // without the ring the data is written right away
+        if (!available() || length == 0)
+        {
+            int error   =   0;  // errno of a failed write
+
+            while (length > 0)
+            {
+                ssize_t written =   pwrite(fd, data, length, offset);
+
+                if (written < 0 && errno == EINTR)
+                    continue;
+                else if (written <= 0)
+                {
+                    error   =   written < 0 ? errno : EIO;
+                    break;
+                }
+
+                data    +=  written;
+                offset  +=  written;
+                length  -=  written;
+            }
+
+            if (callback)
+                callback(error);
+
+            return;
+        }
+
+        std::shared_ptr<write_job>  job(new write_job); // the call, shared by its write buffers
+
+        job->remaining  =   (length + slot_size - 1) / slot_size;
+        job->error      =   0;
+        job->callback   =   callback;
+
+        // copy the data into free write buffers, waiting for one when all are busy
+        for (std::size_t position = 0; position < length; position += slot_size)
+        {
+            std::size_t index;  // the write buffer to use
+            std::size_t size    =   std::min(slot_size, length - position); // bytes going in it
+
+            {
+                std::unique_lock<std::mutex>    lock(slot_mutex);
+
+                slot_freed.wait(lock, [this]() { return !free_slots.empty(); });
+
+                index   =   free_slots.back();
+                free_slots.pop_back();
+            }
+
+            memcpy(slots + index * slot_size, data + position, size);
+
+            writes[index].fd        =   fd;
+            writes[index].offset    =   offset + position;
+            writes[index].length    =   size;
+            writes[index].done      =   0;
+            writes[index].job       =   job;
+
+            write_slot_out(index);
+        }
+    }
+
+    // number of calls into the kernel
+    std::size_t uring_engine::system_calls()
+    {
+        return enters;
+    }
+
+    // number of completed operations
+    std::size_t uring_engine::completed()
+    {
+        return completions;
+    }
+
+    // stop the engine
+    void uring_engine::stop()
+    {
+#ifdef HAVE_IO_URING
+        if (!reaper.joinable())
+            return;
+
+        // let the writes in progress finish
+        {
+            std::unique_lock<std::mutex>    lock(slot_mutex);
+
+            slot_freed.wait(lock, [this]() { return free_slots.size() == writes.size(); });
+        }
+
+        stopping    =   true;
+
+        // wake the thread, which sees the flag after handling this
+        submit([](io_uring_sqe *entry) {
+            entry->opcode       =   IORING_OP_NOP;
+            entry->user_data    =   tag(kind_wake, 0);
+        });
+
+        reaper.join();
+#endif
+    }
+}
@@ -0,0 +1,320 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+
+#ifndef URING_ENGINE_H
+#define URING_ENGINE_H 1
+
+#include <map>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+// multishot receive and provided buffer rings need the headers of linux 6.0 or newer
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#if defined(IORING_RECV_MULTISHOT)
+#define HAVE_IO_URING 1
+#endif
+#endif
+
+// the kernel structures, only used through pointers
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace nntp
+{
+    /**
+      * @class  nntp::uring_engine
+      *
+      * A single io_uring shared by many plain connections and by the writes to the output
+      * files. Every watched socket has one multishot receive armed, which picks a buffer
+      * from a ring of provided buffers each time data arrives, so the engine needs no system
+      * call per socket to receive. One thread reaps the completions of all sockets and files
+      * in batches. File writes are copied into registered buffers and finish in the
+      * background, which lets the disk work while the network keeps receiving.
+      *
+      * A received buffer belongs to the receiver until it hands it back with release(), so
+      * the data is read straight from where the kernel put it. A receiver that falls behind
+      * keeps its buffers; once the ring runs dry the receives stop until buffers come back,
+      * and the kernel stops accepting data, so tcp flow control slows the servers down.
+      *
+      * Without io_uring, or on a kernel too old for multishot receive, available() returns
+      * false, watch() refuses every socket and write_file() writes synchronously, so callers
+      * do not need a code path of their own.
+      */
+    class uring_engine
+    {
+        public:
+            /**
+              * Handler called with data received on a watched socket
+              *
+              * @note   The data stays valid until the buffer is given back with
+              *         release(), which has to happen for every buffer, also after
+              *         the socket is no longer watched. A length of zero means the
+              *         socket was closed, either by the server (error zero) or
+              *         because of the given errno, and carries no buffer.
+              */
+            typedef std::function<void(std::uint16_t buffer, const char *data, std::size_t length, int error)> receive_handler;
+
+            /**
+              * Callback called when a write to a file finished
+              *
+              * @note   The error is zero on success, an errno otherwise
+              */
+            typedef std::function<void(int error)>                                          write_callback;
+        private:
+            // a call to write_file, which can take several write buffers
+            struct write_job
+            {
+                std::size_t                     remaining;      // buffers not written yet
+                int                             error;          // first error that occurred, zero if none
+                write_callback                  callback;       // called once everything is written
+            };
+
+            // a socket with a multishot receive
+            struct watched_socket
+            {
+                int                             fd;             // the socket
+                receive_handler                 handler;        // gets the received data
+                bool                            starved;        // the receive stopped for lack of buffers
+            };
+
+            // a registered write buffer and the part of a file it goes to
+            struct write_slot
+            {
+                int                             fd;             // the file to write to
+                std::uint64_t                   offset;         // where in the file the buffer goes
+                std::size_t                     length;         // number of bytes in the buffer
+                std::size_t                     done;           // number of bytes written so far
+                std::shared_ptr<write_job>      job;            // the call the buffer belongs to
+            };
+
+
+            int                                 ring;           // the io_uring, -1 when not available
+            std::size_t                         buffer_size;    // size of each provided receive buffer
+            std::size_t                         buffer_count;   // number of provided receive buffers
+            std::size_t                         slot_size;      // size of each registered write buffer
+            char                                *buffers;       // memory of the provided receive buffers
+            char                                *slots;         // memory of the registered write buffers
+            void                                *buffer_ring;   // the ring handing receive buffers to the kernel
+            std::uint16_t                       buffer_tail;    // where the next receive buffer goes in the ring
+            std::mutex                          buffer_mutex;   // protects the tail, buffers come back from any thread
+            std::atomic<std::size_t>            buffers_free;   // receive buffers the kernel can fill
+            std::size_t                         rearm_level;    // free receive buffers needed to restart starved receives
+            std::atomic<std::size_t>            starved;        // sockets waiting for buffers to come back
+            void                                *sq_ring;       // submission queue ring, mapped from the kernel
+            void                                *cq_ring;       // completion queue ring, mapped from the kernel
+            io_uring_sqe                        *sqes;          // submission queue entries, mapped from the kernel
+            io_uring_cqe                        *cqes;          // completion queue entries, inside the completion ring
+            std::size_t                         sq_ring_size;   // mapped size of the submission queue ring
+            std::size_t                         cq_ring_size;   // mapped size of the completion queue ring
+            std::size_t                         sqes_size;      // mapped size of the submission queue entries
+            unsigned                            sq_entries;     // number of submission queue entries
+            unsigned                            *sq_head;       // first entry the kernel did not consume yet
+            unsigned                            *sq_tail;       // entry after the last one we queued
+            unsigned                            *sq_mask;       // mask to turn a position into an index
+            unsigned                            *cq_head;       // first completion we did not reap yet
+            unsigned                            *cq_tail;       // completion after the last one the kernel posted
+            unsigned                            *cq_mask;       // mask to turn a position into an index
+            std::mutex                          submit_mutex;   // protects the submission queue
+            std::size_t                         queued;         // entries in the submission queue not yet submitted
+            std::recursive_mutex                handler_mutex;  // held while handlers run, protects the handlers
+            std::map<std::uint64_t, watched_socket> handlers;   // watched sockets by id
+            std::uint64_t                       next_id;        // id of the next watched socket
+            std::mutex                          slot_mutex;     // protects the free write slots
+            std::condition_variable             slot_freed;     // signalled when a write slot is released
+            std::vector<std::size_t>            free_slots;     // write slots that can be used
+            std::vector<write_slot>             writes;         // every write slot
+            std::atomic<std::size_t>            enters;         // number of io_uring_enter calls
+            std::atomic<std::size_t>            completions;    // number of completions reaped
+            std::atomic<bool>                   stopping;       // set when the engine stops
+            std::thread                         reaper;         // reaps completions and runs handlers
+
+            uring_engine(const uring_engine&);
+            uring_engine& operator=(const uring_engine&);
+
+            /**
+              * Set up the ring, the buffers and the reaping thread
+              *
+              * @param  entries     size of the submission queue
+              * @param  slot_count  number of registered write buffers
+              * @return whether everything is in place
+              */
+            bool setup(std::size_t entries, std::size_t slot_count);
+
+            /**
+              * Check whether the kernel supports multishot receive, by receiving a
+              * byte on a socket pair
+              *
+              * @note   Linux 5.19 has provided buffer rings, but not multishot receive.
+              *         Only called from setup(), before the reaping thread runs.
+              *
+              * @return whether multishot receive works
+              */
+            bool probe_multishot();
+
+            /**
+              * Release the ring and its memory
+              */
+            void teardown();
+
+            /**
+              * Queue a submission and hand it to the kernel
+              *
+              * @note   From the reaping thread the entry waits for its next call
+              *         into the kernel, so it goes out together with that batch.
+              *
+              * @param  fill    fills in the zeroed submission queue entry
+              */
+            void submit(const std::function<void(io_uring_sqe *entry)>& fill);
+
+            /**
+              * Hand a receive buffer back to the kernel
+              *
+              * @param  id  the buffer id
+              */
+            void recycle(std::uint16_t id);
+
+            /**
+              * Arm the multishot receive of a watched socket
+              *
+              * @param  id  the id of the socket
+              * @param  fd  the socket
+              */
+            void arm(std::uint64_t id, int fd);
+
+            /**
+              * Write the remainder of a write slot to its file
+              *
+              * @param  index   the slot to write
+              */
+            void write_slot_out(std::size_t index);
+
+            /**
+              * Handle a single completion
+              *
+              * @param  user_data   what the submission was for
+              * @param  result      the result of the operation
+              * @param  flags       the completion flags
+              */
+            void complete(std::uint64_t user_data, int result, std::uint32_t flags);
+
+            /**
+              * Reap completions until the engine stops
+              */
+            void run();
+        public:
+            /**
+              * Start the engine
+              *
+              * @param  entries         size of the submission queue
+              * @param  buffer_count    number of receive buffers, a power of two
+              * @param  buffer_size     size of each receive buffer
+              * @param  slot_count      number of buffers for writing files
+              * @param  slot_size       size of each buffer for writing files
+              */
+            uring_engine(std::size_t entries = 256, std::size_t buffer_count = 512, std::size_t buffer_size = 65536,
+                         std::size_t slot_count = 16, std::size_t slot_size = 1048576);
+
+            /**
+              * Destructor, stops the engine
+              */
+            ~uring_engine();
+
+            /**
+              * @return whether io_uring is used
+              */
+            bool available();
+
+            /**
+              * Start receiving on a connected socket
+              *
+              * @note   The handler runs on the thread of the engine, it should not block.
+              *
+              * @param  fd      the socket
+              * @param  handler the handler for the received data
+              * @return whether the socket is watched, false if the engine is not available
+              */
+            bool watch(int fd, receive_handler handler);
+
+            /**
+              * Stop receiving on a socket
+              *
+              * @note   Once this returns the handler of the socket will not be called
+              *         again, so the socket can be closed safely.
+              *
+              * @param  fd  the socket
+              */
+            void unwatch(int fd);
+
+            /**
+              * Give a receive buffer back once its data is consumed
+              *
+              * @note   Safe to call from any thread, but not while holding a lock
+              *         the handlers take, as it may arm receives again
+              *
+              * @param  buffer  the buffer passed to the handler
+              */
+            void release(std::uint16_t buffer);
+
+            /**
+              * Write data to a file at the given offset
+              *
+              * @note   The data is copied before this returns, so the buffer can be reused
+              *         immediately. This blocks only when all write buffers are in use.
+              *         Without io_uring the data is written, and the callback called,
+              *         before this returns. Never call this from a handler or callback
+              *         of the engine, only the engine can free a write buffer.
+              *
+              * @param  fd          the file, opened for writing
+              * @param  data        the data to write
+              * @param  length      the number of bytes to write
+              * @param  offset      where in the file to write it
+              * @param  callback    called on the thread of the engine when the data is written
+              */
+            void write_file(int fd, const char *data, std::size_t length, std::uint64_t offset, write_callback callback);
+
+            /**
+              * Get the number of calls into the kernel made so far
+              *
+              * @return the number of io_uring_enter calls
+              */
+            std::size_t system_calls();
+
+            /**
+              * Get the number of operations completed so far
+              *
+              * @return the number of completions
+              */
+            std::size_t completed();
+
+            /**
+              * Stop the engine and wait for its thread to finish
+              *
+              * @note   Writes still in progress are finished first
+              */
+            void stop();
+    };
+}
+
+#endif /* URING_ENGINE_H */
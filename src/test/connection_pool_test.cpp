@@ -0,0 +1,96 @@
+/**
+ * This file is part of libnntp.
+ *
+ * libnntp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnntp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <atomic>
+#include <new>
+#include <vector>
+
+#include "exceptions.h"
+#include "mock_server.h"
+#include "connection_pool.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+namespace
+{
+  int failures = 0;   // number of checks that failed
+  
+  // report a failed check
+  void check(bool passed, const char *what)
+  {
+    if (passed)
+      return;
+    
+    cerr << "FAILED: " << what << endl;
+    ++failures;
+  }
+}
+
+int main()
+{
+  nntp::mock_settings     mock;           // a plain server on a free port
+  
+  mock.articles       =   1;
+  mock.article_size   =   1024;
+  
+  nntp::mock_server       server(mock);
+  nntp::server_settings   settings;       // the pool under test
+  std::atomic<int>        attempts(0);    // number of sessions that tried to log in
+  
+  settings.host           =   "127.0.0.1";
+  settings.service        =   server.port();
+  settings.secure         =   false;
+  settings.connections    =   4;
+  
+  // every session but one fails to log in, each in a different way
+  settings.authenticate   =   [&attempts](nntp::nntp&) -> bool {
+    switch (attempts++)
+    {
+      case 0:   throw nntp::decode_exception("Unexpected return code");
+      case 1:   throw nntp::server_exception("Line too long for the receive buffer");
+      case 2:   throw std::bad_alloc();
+      default:  return true;
+    }
+  };
+  
+  {
+    nntp::connection_pool pool(settings);
+    
+    // the exceptions stay on the threads opening the connections
+    check(pool.open() == 1, "only the session that logged in is ready");
+    check(attempts == 4, "every session tried to log in");
+    
+    std::vector<nntp::connection_lease> leases;   // every session in the pool
+    
+    // the sessions that failed are opened again when leased
+    leases.reserve(pool.size());
+    
+    for (std::size_t i = 0; i < pool.size(); ++i)
+    {
+      leases.push_back(pool.acquire());
+      check(leases.back()->connected(), "a leased session is connected");
+    }
+  }
+  
+  if (failures == 0)
+    cout << "connection_pool: all checks passed" << endl;
+  
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+/**
+ * This file is part of libnntp.
+ *
+ * libnntp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnntp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "crc32.h"
+#include "stream_encoder.h"
+#include "decoded_article.h"
+#include "crc_accumulator.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+namespace
+{
+  int failures = 0;   // number of checks that failed
+  
+  // report a failed check
+  void check(bool passed, const char *what)
+  {
+    if (passed)
+      return;
+    
+    cerr << "FAILED: " << what << endl;
+    ++failures;
+  }
+  
+  // encode part of a file as a complete article body
+  std::string encode(const std::string& file, long part, long total, long begin, long end)
+  {
+    nntp::yenc::stream_encoder  encoder("test.bin", file.size(), part, total, begin, end);
+    std::vector<char>           buffer(encoder.encoded_size(end - begin + 1));
+    std::string                 body = encoder.header();
+    
+    body.append(&buffer[0], encoder.feed(file.data() + begin - 1, end - begin + 1, &buffer[0], buffer.size()));
+    body.append(encoder.footer());
+    
+    return body;
+  }
+  
+  // decode every part of a file, in the given order
+  std::vector<nntp::decoded_article_ptr> split(const std::string& file, long part_size, const std::vector<long>& order)
+  {
+    std::vector<nntp::decoded_article_ptr>  parts;
+    long                                    total = (file.size() + part_size - 1) / part_size;
+    
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+      long        begin   = (order[i] - 1) * part_size + 1;
+      long        end     = std::min<long>(begin + part_size - 1, file.size());
+      std::string body    = encode(file, order[i], total, begin, end);
+      
+      parts.push_back(nntp::decoded_article_ptr(new nntp::decoded_article(body.data(), body.size())));
+    }
+    
+    return parts;
+  }
+}
+
+int main()
+{
+  std::string file;   // the file that is posted in parts
+  uint32_t    crc;    // checksum reported by the accumulator
+  
+  for (int i = 0; i < 10000; ++i)
+    file.push_back((char) (i * 7 + i / 251));
+  
+  uint32_t expected = nntp::yenc::crc32(0, file.data(), file.size());
+  
+  // parts in order, the first one starting at the first byte of the file
+  {
+    std::vector<long>                       order = { 1, 2, 3, 4 };
+    std::vector<nntp::decoded_article_ptr>  parts = split(file, 3000, order);
+    nntp::crc_accumulator                   accumulator(file.size());
+    
+    check(parts[0]->multipart() && parts[0]->begin() == 0, "first part starts at offset 0");
+    
+    for (std::size_t i = 0; i < parts.size(); ++i)
+      check(accumulator.add(parts[i]), "adding a part in order");
+    
+    check(accumulator.complete(), "all parts in order complete the file");
+    check(accumulator.crc(crc) && crc == expected, "checksum of parts in order");
+    check(accumulator.check(expected) == nntp::crc_valid, "check of parts in order");
+  }
+  
+  // parts out of order, merged from both sides
+  {
+    std::vector<long>                       order = { 3, 1, 4, 2 };
+    std::vector<nntp::decoded_article_ptr>  parts = split(file, 3000, order);
+    nntp::crc_accumulator                   accumulator(file.size());
+    
+    for (std::size_t i = 0; i < parts.size(); ++i)
+    {
+      check(!accumulator.complete(), "incomplete before the last part");
+      check(accumulator.add(parts[i]), "adding a part out of order");
+    }
+    
+    check(accumulator.complete(), "all parts out of order complete the file");
+    check(accumulator.crc(crc) && crc == expected, "checksum of parts out of order");
+  }
+  
+  // the same part twice
+  {
+    std::vector<long>                       order = { 2, 2 };
+    std::vector<nntp::decoded_article_ptr>  parts = split(file, 3000, order);
+    nntp::crc_accumulator                   accumulator(file.size());
+    
+    check(accumulator.add(parts[0]), "adding a part once");
+    check(!accumulator.add(parts[1]), "adding a part twice");
+    check(!accumulator.complete(), "a single part does not complete the file");
+  }
+  
+  if (failures == 0)
+    cout << "crc_accumulator: all checks passed" << endl;
+  
+  return failures == 0 ? 0 : 1;
+}
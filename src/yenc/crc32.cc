@@ -0,0 +1,267 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#include <string.h>
+#include "crc32.h"
+#include "cpu_features.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace nntp
+{
+    namespace yenc
+    {
+        /**
+          * Lookup tables for the slice-by-16 kernel, entry [n][b] is the crc of
+          * byte b followed by n zero bytes
+          */
+        struct crc_tables
+        {
+            uint32_t    table[16][256];
+
+            // generate the tables
+            crc_tables()
+            {
+                for (uint32_t byte = 0; byte < 256; ++byte)
+                {
+                    uint32_t    crc =   byte;
+
+                    for (int bit = 0; bit < 8; ++bit)
+                        crc =   (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+
+                    table[0][byte]  =   crc;
+                }
+
+                for (int slice = 1; slice < 16; ++slice)
+                    for (int byte = 0; byte < 256; ++byte)
+                        table[slice][byte]  =   (table[slice - 1][byte] >> 8) ^ table[0][table[slice - 1][byte] & 0xff];
+            }
+        };
+
+        // get the lookup tables, generated on first use
+        static const crc_tables& tables()
+        {
+            static const crc_tables instance;
+
+            return instance;
+        }
+
+        // sixteen bytes at a time using lookup tables
+        uint32_t crc32_slice16(uint32_t crc, const char *data, std::size_t length)
+        {
+            const uint32_t      (*table)[256]   =   tables().table;
+            const unsigned char *current        =   (const unsigned char *) data;
+            uint32_t            words[4];       // next sixteen bytes
+
+            crc =   ~crc;
+
+            while (length >= 16)
+            {
+                // read the words in little endian order
+                memcpy(words, current, 16);
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+                for (int word = 0; word < 4; ++word)
+                    words[word] =   __builtin_bswap32(words[word]);
+#endif
+
+                words[0]    ^=  crc;
+
+                crc =   table[15][words[0] & 0xff] ^ table[14][(words[0] >> 8) & 0xff] ^ table[13][(words[0] >> 16) & 0xff] ^ table[12][words[0] >> 24]
+                    ^   table[11][words[1] & 0xff] ^ table[10][(words[1] >> 8) & 0xff] ^ table[ 9][(words[1] >> 16) & 0xff] ^ table[ 8][words[1] >> 24]
+                    ^   table[ 7][words[2] & 0xff] ^ table[ 6][(words[2] >> 8) & 0xff] ^ table[ 5][(words[2] >> 16) & 0xff] ^ table[ 4][words[2] >> 24]
+                    ^   table[ 3][words[3] & 0xff] ^ table[ 2][(words[3] >> 8) & 0xff] ^ table[ 1][(words[3] >> 16) & 0xff] ^ table[ 0][words[3] >> 24];
+
+                current +=  16;
+                length  -=  16;
+            }
+
+            // and the remainder one byte at a time
+            while (length-- > 0)
+                crc =   (crc >> 8) ^ table[0][(crc ^ *current++) & 0xff];
+
+            return ~crc;
+        }
+
+#if defined(__x86_64__) || defined(__i386__)
+        /**
+          * Fold 64 bytes at a time using carry-less multiplication, after "Fast CRC
+          * Computation for Generic Polynomials Using PCLMULQDQ Instruction" (Intel)
+          */
+        __attribute__((target("pclmul,sse4.1")))
+        uint32_t crc32_pclmul(uint32_t crc, const char *data, std::size_t length)
+        {
+            // the folding constants for the bit-reflected polynomial
+            const __m128i   k1k2    =   _mm_set_epi64x(0x01c6e41596LL, 0x0154442bd4LL);
+            const __m128i   k3k4    =   _mm_set_epi64x(0x00ccaa009eLL, 0x01751997d0LL);
+            const __m128i   k5k0    =   _mm_set_epi64x(0x0000000000LL, 0x0163cd6124LL);
+            const __m128i   poly    =   _mm_set_epi64x(0x01f7011641LL, 0x01db710641LL);
+            const __m128i   mask    =   _mm_setr_epi32(~0, 0, ~0, 0);
+            __m128i         x1, x2, x3, x4, x5, x6, x7, x8;
+
+            // folding needs at least one block of 64 bytes
+            if (length < 64)
+                return crc32_slice16(crc, data, length);
+
+            x1  =   _mm_loadu_si128((const __m128i *) (data + 0x00));
+            x2  =   _mm_loadu_si128((const __m128i *) (data + 0x10));
+            x3  =   _mm_loadu_si128((const __m128i *) (data + 0x20));
+            x4  =   _mm_loadu_si128((const __m128i *) (data + 0x30));
+            x1  =   _mm_xor_si128(x1, _mm_cvtsi32_si128(~crc));
+
+            data    +=  64;
+            length  -=  64;
+
+            // fold four blocks in parallel
+            while (length >= 64)
+            {
+                x5  =   _mm_clmulepi64_si128(x1, k1k2, 0x00);
+                x6  =   _mm_clmulepi64_si128(x2, k1k2, 0x00);
+                x7  =   _mm_clmulepi64_si128(x3, k1k2, 0x00);
+                x8  =   _mm_clmulepi64_si128(x4, k1k2, 0x00);
+
+                x1  =   _mm_clmulepi64_si128(x1, k1k2, 0x11);
+                x2  =   _mm_clmulepi64_si128(x2, k1k2, 0x11);
+                x3  =   _mm_clmulepi64_si128(x3, k1k2, 0x11);
+                x4  =   _mm_clmulepi64_si128(x4, k1k2, 0x11);
+
+                x1  =   _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *) (data + 0x00)));
+                x2  =   _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *) (data + 0x10)));
+                x3  =   _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *) (data + 0x20)));
+                x4  =   _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *) (data + 0x30)));
+
+                data    +=  64;
+                length  -=  64;
+            }
+
+            // fold the four blocks into one
+            x5  =   _mm_clmulepi64_si128(x1, k3k4, 0x00);
+            x1  =   _mm_clmulepi64_si128(x1, k3k4, 0x11);
+            x1  =   _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+            x5  =   _mm_clmulepi64_si128(x1, k3k4, 0x00);
+            x1  =   _mm_clmulepi64_si128(x1, k3k4, 0x11);
+            x1  =   _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+            x5  =   _mm_clmulepi64_si128(x1, k3k4, 0x00);
+            x1  =   _mm_clmulepi64_si128(x1, k3k4, 0x11);
+            x1  =   _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+            // fold any remaining blocks of 16 bytes
+            while (length >= 16)
+            {
+                x5  =   _mm_clmulepi64_si128(x1, k3k4, 0x00);
+                x1  =   _mm_clmulepi64_si128(x1, k3k4, 0x11);
+                x1  =   _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i *) data)), x5);
+
+                data    +=  16;
+                length  -=  16;
+            }
+
+            // fold 128 bits down to 64
+            x2  =   _mm_clmulepi64_si128(x1, k3k4, 0x10);
+            x1  =   _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+            x2  =   _mm_srli_si128(x1, 4);
+            x1  =   _mm_clmulepi64_si128(_mm_and_si128(x1, mask), k5k0, 0x00);
+            x1  =   _mm_xor_si128(x1, x2);
+
+            // barrett reduction to 32 bits
+            x2  =   _mm_clmulepi64_si128(_mm_and_si128(x1, mask), poly, 0x10);
+            x2  =   _mm_clmulepi64_si128(_mm_and_si128(x2, mask), poly, 0x00);
+            x1  =   _mm_xor_si128(x1, x2);
+
+            crc =   ~(uint32_t) _mm_extract_epi32(x1, 1);
+
+            // and the last few bytes using the tables
+            return crc32_slice16(crc, data, length);
+        }
+#endif
+
+        // multiply two polynomials modulo the crc polynomial, bit-reflected
+        static uint32_t multiply(uint32_t first, uint32_t second)
+        {
+            uint32_t    product =   0;
+
+            for (uint32_t bit = 0x80000000; bit != 0; bit >>= 1)
+            {
+                if (first & bit)
+                    product ^=  second;
+
+                second  =   second & 1 ? (second >> 1) ^ 0xedb88320 : second >> 1;
+            }
+
+            return product;
+        }
+
+        /**
+          * Powers of x used to shift a crc over a number of zero bytes,
+          * entry n is x^(2^n) modulo the crc polynomial
+          */
+        struct crc_powers
+        {
+            uint32_t    power[64];
+
+            // generate the powers by repeated squaring
+            crc_powers()
+            {
+                power[0]    =   0x40000000;
+
+                for (int n = 1; n < 64; ++n)
+                    power[n]    =   multiply(power[n - 1], power[n - 1]);
+            }
+        };
+
+        // combine the checksums of two consecutive blocks
+        uint32_t crc32_combine(uint32_t first, uint32_t second, uint64_t length)
+        {
+            static const crc_powers powers;
+
+            uint32_t    shift   =   0x80000000; // x^0
+            int         n       =   3;          // a byte is x^(2^3)
+
+            // x^(8 * length) modulo the polynomial
+            for (; length != 0; length >>= 1, ++n)
+                if (length & 1)
+                    shift   =   multiply(powers.power[n & 63], shift);
+
+            // shift the first crc over the second block
+            return multiply(shift, first) ^ second;
+        }
+
+        // pick the fastest kernel for this cpu
+        static crc_kernel select_crc32()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            if (cpu().pclmul && cpu().sse41)
+                return crc32_pclmul;
+#endif
+
+            return crc32_slice16;
+        }
+
+        // get the fastest kernel the current cpu supports
+        crc_kernel crc32_kernel()
+        {
+            static const crc_kernel kernel = select_crc32();
+
+            return kernel;
+        }
+    }
+}
@@ -0,0 +1,87 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef YENC_CRC32_H
+#define YENC_CRC32_H 1
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace nntp
+{
+    namespace yenc
+    {
+        /**
+          * Update a crc32 (the zlib/yEnc polynomial) with more data
+          *
+          * @note   Start with a crc of 0. The result of one call can be passed
+          *         to the next to checksum data that arrives in pieces.
+          *
+          * @param  crc     checksum of the data so far
+          * @param  data    data to add to the checksum
+          * @param  length  size of the data
+          * @return the checksum including the new data
+          */
+        typedef uint32_t (*crc_kernel)(uint32_t crc, const char *data, std::size_t length);
+
+        /**
+          * Portable kernel using sixteen lookup tables, sixteen bytes at a time
+          */
+        uint32_t crc32_slice16(uint32_t crc, const char *data, std::size_t length);
+
+#if defined(__x86_64__) || defined(__i386__)
+        /**
+          * Kernel folding 64 bytes at a time with carry-less multiplication,
+          * may only be called when the cpu supports pclmul and sse4.1
+          */
+        uint32_t crc32_pclmul(uint32_t crc, const char *data, std::size_t length);
+#endif
+
+        /**
+          * Get the fastest kernel the current cpu supports
+          *
+          * @note   The kernel is selected once, on first use
+          *
+          * @return the crc kernel
+          */
+        crc_kernel crc32_kernel();
+
+        /**
+          * Combine the checksums of two consecutive blocks of data
+          *
+          * @note   This takes O(log length) time, none of the data is needed
+          *
+          * @param  first   crc32 of the first block
+          * @param  second  crc32 of the second block
+          * @param  length  size of the second block
+          * @return the crc32 of both blocks together
+          */
+        uint32_t crc32_combine(uint32_t first, uint32_t second, uint64_t length);
+
+        /**
+          * Update a checksum using the fastest kernel available
+          *
+          * @see    crc_kernel
+          */
+        inline uint32_t crc32(uint32_t crc, const char *data, std::size_t length)
+        {
+            return crc32_kernel()(crc, data, length);
+        }
+    }
+}
+
+#endif /* YENC_CRC32_H */
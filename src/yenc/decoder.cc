@@ -0,0 +1,290 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#include <algorithm>
+#include "decoder.h"
+#include "crc32.h"
+#include "cpu_features.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace nntp
+{
+    namespace yenc
+    {
+        // decode a single character, returns false when no more progress can be made
+        static inline bool decode_character(const char *&source, char *&target, char *target_end, decode_state &state)
+        {
+            char    character   =   *source;    // character to decode
+
+            switch (state)
+            {
+                case state_line_escape:
+                    // a =y at the start of a line is a keyword line, the data ends here
+                    if (character == 'y')
+                    {
+                        state   =   state_end;
+                        ++source;
+                        return false;
+                    }
+
+                    // otherwise it is just an escaped character
+                    // fall through
+                case state_escape:
+                    // we need room for the character
+                    if (target == target_end)
+                        return false;
+
+                    *target++   =   character - 42 - 64;
+                    state       =   state_data;
+                    break;
+
+                case state_line_start:
+                    // remove the extra dot from a dot-stuffed line
+                    if (character == '.')
+                    {
+                        state   =   state_data;
+                        break;
+                    }
+
+                    // otherwise it is a normal character
+                    // fall through
+                case state_data:
+                    // carriage returns do not change our position in the line
+                    if (character == '\r')
+                        break;
+
+                    // a line feed starts a new line
+                    if (character == '\n')
+                    {
+                        state   =   state_line_start;
+                        break;
+                    }
+
+                    // escape the next character
+                    if (character == '=')
+                    {
+                        state   =   state == state_line_start ? state_line_escape : state_escape;
+                        break;
+                    }
+
+                    // we need room for the character
+                    if (target == target_end)
+                        return false;
+
+                    *target++   =   character - 42;
+                    state       =   state_data;
+                    break;
+
+                case state_end:
+                    // nothing left to decode
+                    return false;
+            }
+
+            // character consumed
+            ++source;
+            return true;
+        }
+
+        // decode one character at a time
+        void decode_scalar(const char *&source, const char *source_end, char *&target, char *target_end, decode_state &state)
+        {
+            while (source < source_end && decode_character(source, target, target_end, state))
+                ;
+        }
+
+#if defined(__x86_64__) || defined(__i386__)
+        // decode 16 characters at a time
+        __attribute__((target("sse2")))
+        void decode_sse2(const char *&source, const char *source_end, char *&target, char *target_end, decode_state &state)
+        {
+            const __m128i   escape      =   _mm_set1_epi8('=');
+            const __m128i   cr          =   _mm_set1_epi8('\r');
+            const __m128i   lf          =   _mm_set1_epi8('\n');
+            const __m128i   offset      =   _mm_set1_epi8(42);
+
+            while (source < source_end)
+            {
+                // vectors can only be used in the middle of a line
+                while (state == state_data && source + 16 <= source_end && target + 16 <= target_end)
+                {
+                    __m128i     data    =   _mm_loadu_si128((const __m128i *) source);
+                    __m128i     special =   _mm_or_si128(_mm_cmpeq_epi8(data, escape), _mm_or_si128(_mm_cmpeq_epi8(data, cr), _mm_cmpeq_epi8(data, lf)));
+                    unsigned    mask    =   _mm_movemask_epi8(special);
+
+                    // write the whole vector, anything after a special character is overwritten later
+                    _mm_storeu_si128((__m128i *) target, _mm_sub_epi8(data, offset));
+
+                    // without special characters the whole vector is done
+                    if (mask == 0)
+                    {
+                        source  +=  16;
+                        target  +=  16;
+                        continue;
+                    }
+
+                    // skip to the special character and handle it below
+                    source  +=  __builtin_ctz(mask);
+                    target  +=  __builtin_ctz(mask);
+                    break;
+                }
+
+                // handle special characters and the tail one at a time
+                if (source == source_end || !decode_character(source, target, target_end, state))
+                    break;
+            }
+        }
+
+        // decode 32 characters at a time
+        __attribute__((target("avx2")))
+        void decode_avx2(const char *&source, const char *source_end, char *&target, char *target_end, decode_state &state)
+        {
+            const __m256i   escape      =   _mm256_set1_epi8('=');
+            const __m256i   cr          =   _mm256_set1_epi8('\r');
+            const __m256i   lf          =   _mm256_set1_epi8('\n');
+            const __m256i   offset      =   _mm256_set1_epi8(42);
+
+            while (source < source_end)
+            {
+                // vectors can only be used in the middle of a line
+                while (state == state_data && source + 32 <= source_end && target + 32 <= target_end)
+                {
+                    __m256i     data    =   _mm256_loadu_si256((const __m256i *) source);
+                    __m256i     special =   _mm256_or_si256(_mm256_cmpeq_epi8(data, escape), _mm256_or_si256(_mm256_cmpeq_epi8(data, cr), _mm256_cmpeq_epi8(data, lf)));
+                    unsigned    mask    =   _mm256_movemask_epi8(special);
+
+                    // write the whole vector, anything after a special character is overwritten later
+                    _mm256_storeu_si256((__m256i *) target, _mm256_sub_epi8(data, offset));
+
+                    // without special characters the whole vector is done
+                    if (mask == 0)
+                    {
+                        source  +=  32;
+                        target  +=  32;
+                        continue;
+                    }
+
+                    // skip to the special character and handle it below
+                    source  +=  __builtin_ctz(mask);
+                    target  +=  __builtin_ctz(mask);
+                    break;
+                }
+
+                // handle special characters and the tail one at a time
+                if (source == source_end || !decode_character(source, target, target_end, state))
+                    break;
+            }
+        }
+
+        // decode 64 characters at a time
+        __attribute__((target("avx512f,avx512bw")))
+        void decode_avx512(const char *&source, const char *source_end, char *&target, char *target_end, decode_state &state)
+        {
+            const __m512i   escape      =   _mm512_set1_epi8('=');
+            const __m512i   cr          =   _mm512_set1_epi8('\r');
+            const __m512i   lf          =   _mm512_set1_epi8('\n');
+            const __m512i   offset      =   _mm512_set1_epi8(42);
+
+            while (source < source_end)
+            {
+                // vectors can only be used in the middle of a line
+                while (state == state_data && source + 64 <= source_end && target + 64 <= target_end)
+                {
+                    __m512i             data    =   _mm512_loadu_si512((const void *) source);
+                    unsigned long long  mask    =   _mm512_cmpeq_epi8_mask(data, escape) | _mm512_cmpeq_epi8_mask(data, cr) | _mm512_cmpeq_epi8_mask(data, lf);
+
+                    // write the whole vector, anything after a special character is overwritten later
+                    _mm512_storeu_si512((void *) target, _mm512_sub_epi8(data, offset));
+
+                    // without special characters the whole vector is done
+                    if (mask == 0)
+                    {
+                        source  +=  64;
+                        target  +=  64;
+                        continue;
+                    }
+
+                    // skip to the special character and handle it below
+                    source  +=  __builtin_ctzll(mask);
+                    target  +=  __builtin_ctzll(mask);
+                    break;
+                }
+
+                // handle special characters and the tail one at a time
+                if (source == source_end || !decode_character(source, target, target_end, state))
+                    break;
+            }
+        }
+#endif
+
+        // pick the fastest kernel for this cpu
+        static decode_kernel select_decoder()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            if (cpu().avx512bw)
+                return decode_avx512;
+
+            if (cpu().avx2)
+                return decode_avx2;
+
+            if (cpu().sse2)
+                return decode_sse2;
+#endif
+
+            return decode_scalar;
+        }
+
+        // get the fastest kernel the current cpu supports
+        decode_kernel decoder()
+        {
+            static const decode_kernel kernel = select_decoder();
+
+            return kernel;
+        }
+
+        // decode data and checksum it in the same pass
+        void decode_crc(const char *&source, const char *source_end, char *&target, char *target_end, decode_state &state, uint32_t &crc)
+        {
+            decode_crc(source, source_end, target, target_end, state, crc, decoder());
+        }
+
+        // decode data and checksum it in the same pass with a specific kernel
+        void decode_crc(const char *&source, const char *source_end, char *&target, char *target_end, decode_state &state, uint32_t &crc, decode_kernel kernel)
+        {
+            const char  *block_end;     // end of the current block
+            char        *block_target;  // where the current block was written
+
+            while (source < source_end && state != state_end)
+            {
+                // decode a block small enough to stay in the cache
+                block_end       =   source + std::min<std::size_t>(source_end - source, 8192);
+                block_target    =   target;
+
+                kernel(source, block_end, target, target_end, state);
+
+                // and checksum it while it's still there
+                crc =   crc32(crc, block_target, target - block_target);
+
+                // stop if the kernel could not finish the block
+                if (source != block_end)
+                    break;
+            }
+        }
+    }
+}
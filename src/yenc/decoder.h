@@ -0,0 +1,114 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef YENC_DECODER_H
+#define YENC_DECODER_H 1
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace nntp
+{
+    namespace yenc
+    {
+        /**
+          * Position of the decoder within the encoded data. The state is all a kernel needs
+          * to resume, so escape sequences, line breaks and dot-stuffed line starts may be split
+          * at any point between two calls.
+          */
+        enum decode_state
+        {
+            state_data,         // in the middle of a line
+            state_escape,       // previous character was an escape character
+            state_line_start,   // at the beginning of a line
+            state_line_escape,  // escape character at the beginning of a line, could be a keyword line
+            state_end           // a =y keyword line was found, there is no more data
+        };
+
+        /**
+          * Decode yEnc encoded data. Line breaks are skipped, the extra dot of dot-stuffed lines
+          * is removed and decoding stops at the first line starting with =y (normally =yend).
+          *
+          * @note   On return source points to the first character that was not consumed. When
+          *         the state is state_end, the keyword line starts two characters before it.
+          *         The kernel stops early when a character has to be written and the target
+          *         is full.
+          *
+          * @param  source      first character to decode, updated to the first one not consumed
+          * @param  source_end  end of the encoded data
+          * @param  target      where to write the first byte, updated past the last byte written
+          * @param  target_end  end of the target buffer
+          * @param  state       decoder state, updated on return
+          */
+        typedef void (*decode_kernel)(const char *&source, const char *source_end, char *&target, char *target_end, decode_state &state);
+
+        /**
+          * Portable kernel decoding a single character at a time
+          */
+        void decode_scalar(const char *&source, const char *source_end, char *&target, char *target_end, decode_state &state);
+
+#if defined(__x86_64__) || defined(__i386__)
+        /**
+          * Vectorized kernels, these may only be called when the cpu supports them
+          */
+        void decode_sse2(const char *&source, const char *source_end, char *&target, char *target_end, decode_state &state);
+        void decode_avx2(const char *&source, const char *source_end, char *&target, char *target_end, decode_state &state);
+        void decode_avx512(const char *&source, const char *source_end, char *&target, char *target_end, decode_state &state);
+#endif
+
+        /**
+          * Get the fastest kernel the current cpu supports
+          *
+          * @note   The kernel is selected once, on first use
+          *
+          * @return the decode kernel
+          */
+        decode_kernel decoder();
+
+        /**
+          * Decode data using the fastest kernel available
+          *
+          * @see    decode_kernel
+          */
+        inline void decode(const char *&source, const char *source_end, char *&target, char *target_end, decode_state &state)
+        {
+            decoder()(source, source_end, target, target_end, state);
+        }
+
+        /**
+          * Decode data and update the crc32 of the decoded bytes in the same pass. The data
+          * is decoded in blocks small enough for the output to still be in the cache when
+          * it is checksummed.
+          *
+          * @see    decode_kernel
+          *
+          * @param  crc         checksum of the data decoded so far, updated on return
+          */
+        void decode_crc(const char *&source, const char *source_end, char *&target, char *target_end, decode_state &state, uint32_t &crc);
+
+        /**
+          * Decode and checksum data in the same pass with a specific kernel
+          *
+          * @see    decode_crc
+          *
+          * @param  kernel      the kernel to decode with
+          */
+        void decode_crc(const char *&source, const char *source_end, char *&target, char *target_end, decode_state &state, uint32_t &crc, decode_kernel kernel);
+    }
+}
+
+#endif /* YENC_DECODER_H */
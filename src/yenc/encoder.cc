@@ -0,0 +1,272 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#include <algorithm>
+#include "encoder.h"
+#include "crc32.h"
+#include "cpu_features.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace nntp
+{
+    namespace yenc
+    {
+        // most characters a single byte can turn into: escape, character and line break
+        static const std::size_t max_step = 4;
+
+        // encode a single byte, the last one we have may end the last line
+        static inline void encode_character(const char *&source, const char *source_end, char *&target, int &column, int line_length)
+        {
+            char    character   =   *source++ + 42; // the encoded character
+
+            switch (character)
+            {
+                case '\0':
+                case '\n':
+                case '\r':
+                case '=':
+                    // critical characters are always escaped
+                    *target++   =   '=';
+                    character   +=  64;
+                    ++column;
+                    break;
+
+                case '\t':
+                case ' ':
+                    // servers may strip whitespace at the start or end of a line
+                    if (column == 0 || column >= line_length - 1 || source == source_end)
+                    {
+                        *target++   =   '=';
+                        character   +=  64;
+                        ++column;
+                    }
+                    break;
+
+                case '.':
+                    // a line starting with a dot gets an extra one, the server removes it
+                    if (column == 0)
+                        *target++   =   '.';
+                    break;
+            }
+
+            *target++   =   character;
+
+            // wrap the line
+            if (++column >= line_length)
+            {
+                *target++   =   '\r';
+                *target++   =   '\n';
+                column      =   0;
+            }
+        }
+
+        // encode one byte at a time
+        void encode_scalar(const char *&source, const char *source_end, char *&target, char *target_end, int &column, int line_length)
+        {
+            while (source < source_end && (std::size_t) (target_end - target) >= max_step)
+                encode_character(source, source_end, target, column, line_length);
+        }
+
+#if defined(__x86_64__) || defined(__i386__)
+        // encode 16 bytes at a time
+        __attribute__((target("sse2")))
+        void encode_sse2(const char *&source, const char *source_end, char *&target, char *target_end, int &column, int line_length)
+        {
+            const __m128i   offset  =   _mm_set1_epi8(42);
+            const __m128i   nul     =   _mm_setzero_si128();
+            const __m128i   escape  =   _mm_set1_epi8('=');
+            const __m128i   cr      =   _mm_set1_epi8('\r');
+            const __m128i   lf      =   _mm_set1_epi8('\n');
+
+            while (source < source_end && (std::size_t) (target_end - target) >= max_step)
+            {
+                // vectors can only be used away from the line edges and the last byte of the data
+                while (column > 0 && column < line_length - 1 && source + 16 < source_end && target + 16 <= target_end)
+                {
+                    __m128i     data    =   _mm_add_epi8(_mm_loadu_si128((const __m128i *) source), offset);
+                    __m128i     special =   _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(data, nul), _mm_cmpeq_epi8(data, escape)), _mm_or_si128(_mm_cmpeq_epi8(data, cr), _mm_cmpeq_epi8(data, lf)));
+                    unsigned    mask    =   _mm_movemask_epi8(special);
+
+                    // write the whole vector, anything after a critical character is overwritten later
+                    _mm_storeu_si128((__m128i *) target, data);
+
+                    // stop at the first critical character, or before the last column of the line
+                    int         count   =   mask == 0 ? 16 : __builtin_ctz(mask);
+
+                    count   =   std::min(count, line_length - 1 - column);
+                    source  +=  count;
+                    target  +=  count;
+                    column  +=  count;
+
+                    // anything left is handled below
+                    if (count < 16)
+                        break;
+                }
+
+                // handle critical characters and line edges one at a time
+                if (source < source_end && (std::size_t) (target_end - target) >= max_step)
+                    encode_character(source, source_end, target, column, line_length);
+            }
+        }
+
+        // encode 32 bytes at a time
+        __attribute__((target("avx2")))
+        void encode_avx2(const char *&source, const char *source_end, char *&target, char *target_end, int &column, int line_length)
+        {
+            const __m256i   offset  =   _mm256_set1_epi8(42);
+            const __m256i   nul     =   _mm256_setzero_si256();
+            const __m256i   escape  =   _mm256_set1_epi8('=');
+            const __m256i   cr      =   _mm256_set1_epi8('\r');
+            const __m256i   lf      =   _mm256_set1_epi8('\n');
+
+            while (source < source_end && (std::size_t) (target_end - target) >= max_step)
+            {
+                // vectors can only be used away from the line edges and the last byte of the data
+                while (column > 0 && column < line_length - 1 && source + 32 < source_end && target + 32 <= target_end)
+                {
+                    __m256i     data    =   _mm256_add_epi8(_mm256_loadu_si256((const __m256i *) source), offset);
+                    __m256i     special =   _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(data, nul), _mm256_cmpeq_epi8(data, escape)), _mm256_or_si256(_mm256_cmpeq_epi8(data, cr), _mm256_cmpeq_epi8(data, lf)));
+                    unsigned    mask    =   _mm256_movemask_epi8(special);
+
+                    // write the whole vector, anything after a critical character is overwritten later
+                    _mm256_storeu_si256((__m256i *) target, data);
+
+                    // stop at the first critical character, or before the last column of the line
+                    int         count   =   mask == 0 ? 32 : __builtin_ctz(mask);
+
+                    count   =   std::min(count, line_length - 1 - column);
+                    source  +=  count;
+                    target  +=  count;
+                    column  +=  count;
+
+                    // anything left is handled below
+                    if (count < 32)
+                        break;
+                }
+
+                // handle critical characters and line edges one at a time
+                if (source < source_end && (std::size_t) (target_end - target) >= max_step)
+                    encode_character(source, source_end, target, column, line_length);
+            }
+        }
+
+        // encode 64 bytes at a time
+        __attribute__((target("avx512f,avx512bw")))
+        void encode_avx512(const char *&source, const char *source_end, char *&target, char *target_end, int &column, int line_length)
+        {
+            const __m512i   offset  =   _mm512_set1_epi8(42);
+            const __m512i   nul     =   _mm512_setzero_si512();
+            const __m512i   escape  =   _mm512_set1_epi8('=');
+            const __m512i   cr      =   _mm512_set1_epi8('\r');
+            const __m512i   lf      =   _mm512_set1_epi8('\n');
+
+            while (source < source_end && (std::size_t) (target_end - target) >= max_step)
+            {
+                // vectors can only be used away from the line edges and the last byte of the data
+                while (column > 0 && column < line_length - 1 && source + 64 < source_end && target + 64 <= target_end)
+                {
+                    __m512i             data    =   _mm512_add_epi8(_mm512_loadu_si512((const void *) source), offset);
+                    unsigned long long  mask    =   _mm512_cmpeq_epi8_mask(data, nul) | _mm512_cmpeq_epi8_mask(data, escape) | _mm512_cmpeq_epi8_mask(data, cr) | _mm512_cmpeq_epi8_mask(data, lf);
+
+                    // write the whole vector, anything after a critical character is overwritten later
+                    _mm512_storeu_si512((void *) target, data);
+
+                    // stop at the first critical character, or before the last column of the line
+                    int         count   =   mask == 0 ? 64 : __builtin_ctzll(mask);
+
+                    count   =   std::min(count, line_length - 1 - column);
+                    source  +=  count;
+                    target  +=  count;
+                    column  +=  count;
+
+                    // anything left is handled below
+                    if (count < 64)
+                        break;
+                }
+
+                // handle critical characters and line edges one at a time
+                if (source < source_end && (std::size_t) (target_end - target) >= max_step)
+                    encode_character(source, source_end, target, column, line_length);
+            }
+        }
+#endif
+
+        // pick the fastest kernel for this cpu
+        static encode_kernel select_encoder()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            if (cpu().avx512bw)
+                return encode_avx512;
+
+            if (cpu().avx2)
+                return encode_avx2;
+
+            if (cpu().sse2)
+                return encode_sse2;
+#endif
+
+            return encode_scalar;
+        }
+
+        // get the fastest kernel the current cpu supports
+        encode_kernel encoder()
+        {
+            static const encode_kernel kernel = select_encoder();
+
+            return kernel;
+        }
+
+        // largest number of characters some data can encode to
+        std::size_t max_encoded_size(std::size_t length, int line_length)
+        {
+            // every byte may be escaped, and every line may need a dot and a line break
+            return length * 2 + (length * 2 / line_length + 1) * 3 + max_step;
+        }
+
+        // encode data and checksum it in the same pass
+        void encode_crc(const char *&source, const char *source_end, char *&target, char *target_end, int &column, int line_length, uint32_t &crc)
+        {
+            encode_crc(source, source_end, target, target_end, column, line_length, crc, encoder());
+        }
+
+        // encode data and checksum it in the same pass with a specific kernel
+        void encode_crc(const char *&source, const char *source_end, char *&target, char *target_end, int &column, int line_length, uint32_t &crc, encode_kernel kernel)
+        {
+            const char  *block_begin;   // start of the current block
+            const char  *block_end;     // end of the current block
+
+            while (source < source_end)
+            {
+                // encode a block small enough to stay in the cache
+                block_begin =   source;
+                block_end   =   source + std::min<std::size_t>(source_end - source, 8192);
+
+                kernel(source, block_end, target, target_end, column, line_length);
+
+                // and checksum the part that was consumed while it's still there
+                crc =   crc32(crc, block_begin, source - block_begin);
+
+                // stop if the kernel could not finish the block
+                if (source != block_end)
+                    break;
+            }
+        }
+    }
+}
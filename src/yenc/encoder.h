@@ -0,0 +1,97 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef YENC_ENCODER_H
+#define YENC_ENCODER_H 1
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace nntp
+{
+    namespace yenc
+    {
+        /**
+          * Encode data as yEnc. Critical characters are escaped, as is whitespace at the start
+          * or end of a line, lines are wrapped at line_length and lines starting with a dot
+          * are dot-stuffed, so the output can be sent to the server as is.
+          *
+          * @note   The kernel stops when the target is close to full; there is always
+          *         progress while at least max_encoded_size(1, line_length) bytes are free.
+          *
+          * @param  source      first byte to encode, updated to the first one not consumed
+          * @param  source_end  end of the data
+          * @param  target      where to write the first character, updated past the last one written
+          * @param  target_end  end of the target buffer
+          * @param  column      column of the current line, carried between calls
+          * @param  line_length number of characters per line
+          */
+        typedef void (*encode_kernel)(const char *&source, const char *source_end, char *&target, char *target_end, int &column, int line_length);
+
+        /**
+          * Portable kernel encoding a single byte at a time
+          */
+        void encode_scalar(const char *&source, const char *source_end, char *&target, char *target_end, int &column, int line_length);
+
+#if defined(__x86_64__) || defined(__i386__)
+        /**
+          * Vectorized kernels, these may only be called when the cpu supports them
+          */
+        void encode_sse2(const char *&source, const char *source_end, char *&target, char *target_end, int &column, int line_length);
+        void encode_avx2(const char *&source, const char *source_end, char *&target, char *target_end, int &column, int line_length);
+        void encode_avx512(const char *&source, const char *source_end, char *&target, char *target_end, int &column, int line_length);
+#endif
+
+        /**
+          * Get the fastest kernel the current cpu supports
+          *
+          * @note   The kernel is selected once, on first use
+          *
+          * @return the encode kernel
+          */
+        encode_kernel encoder();
+
+        /**
+          * Get the largest number of characters some data can encode to
+          *
+          * @param  length      size of the data
+          * @param  line_length number of characters per line
+          * @return the size of a buffer that always fits the encoded data
+          */
+        std::size_t max_encoded_size(std::size_t length, int line_length);
+
+        /**
+          * Encode data and update the crc32 of the source bytes in the same pass
+          *
+          * @see    encode_kernel
+          *
+          * @param  crc         checksum of the data encoded so far, updated on return
+          */
+        void encode_crc(const char *&source, const char *source_end, char *&target, char *target_end, int &column, int line_length, uint32_t &crc);
+
+        /**
+          * Encode and checksum data in the same pass with a specific kernel
+          *
+          * @see    encode_crc
+          *
+          * @param  kernel      the kernel to encode with
+          */
+        void encode_crc(const char *&source, const char *source_end, char *&target, char *target_end, int &column, int line_length, uint32_t &crc, encode_kernel kernel);
+    }
+}
+
+#endif /* YENC_ENCODER_H */
@@ -0,0 +1,135 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#include <string.h>
+#include "keyword_line.h"
+
+namespace nntp
+{
+    namespace yenc
+    {
+        // read a decimal number, stopping at the first other character
+        static long read_number(const char *current, const char *end)
+        {
+            long    value   =   0;
+
+            for (; current < end && *current >= '0' && *current <= '9'; ++current)
+                value   =   value * 10 + (*current - '0');
+
+            return value;
+        }
+
+        // read a hexadecimal number, stopping at the first other character
+        static uint32_t read_hex(const char *current, const char *end)
+        {
+            uint32_t    value   =   0;
+
+            for (; current < end; ++current)
+            {
+                if (*current >= '0' && *current <= '9')
+                    value   =   (value << 4) | (*current - '0');
+                else if ((*current | 0x20) >= 'a' && (*current | 0x20) <= 'f')
+                    value   =   (value << 4) | ((*current | 0x20) - 'a' + 10);
+                else
+                    break;
+            }
+
+            return value;
+        }
+
+        // parse a keyword line
+        bool keyword_line::parse(const char *keyword, const char *line_begin, const char *line_end)
+        {
+            std::size_t length      =   strlen(keyword);    // length of the keyword
+            const char  *key;                               // start of the parameter name
+            const char  *separator;                         // the = between name and value
+            const char  *value_end;                         // end of the parameter value
+
+            present     =   0;
+            line        =   size    =   part    =   total   =   begin   =   end =   0;
+            crc32       =   pcrc32  =   0;
+            name        =   NULL;
+            name_length =   0;
+
+            // ignore the line break
+            if (line_end > line_begin && *(line_end - 1) == '\n')
+                --line_end;
+            if (line_end > line_begin && *(line_end - 1) == '\r')
+                --line_end;
+
+            // the keyword has to be followed by a space or the end of the line
+            if ((std::size_t) (line_end - line_begin) < length || memcmp(line_begin, keyword, length) != 0)
+                return false;
+            if (line_begin + length < line_end && line_begin[length] != ' ')
+                return false;
+
+            key =   line_begin + length;
+
+            while (key < line_end)
+            {
+                // skip the spaces in front of the parameter
+                if (*key == ' ')
+                {
+                    ++key;
+                    continue;
+                }
+
+                // find the end of the name, a parameter without a value ends the line
+                if ((separator = (const char *) memchr(key, '=', line_end - key)) == NULL)
+                    break;
+
+                // the name runs to the end of the line and may contain spaces
+                if (separator - key == 4 && memcmp(key, "name", 4) == 0)
+                {
+                    present     |=  param_name;
+                    name        =   separator + 1;
+                    name_length =   line_end - name;
+                    break;
+                }
+
+                // other values end at the next space
+                if ((value_end = (const char *) memchr(separator, ' ', line_end - separator)) == NULL)
+                    value_end   =   line_end;
+
+                switch (separator - key)
+                {
+                    case 3:
+                        if (memcmp(key, "end", 3) == 0)         { present |= param_end;     end     =   read_number(separator + 1, value_end); }
+                        break;
+                    case 4:
+                        if (memcmp(key, "line", 4) == 0)        { present |= param_line;    line    =   read_number(separator + 1, value_end); }
+                        else if (memcmp(key, "size", 4) == 0)   { present |= param_size;    size    =   read_number(separator + 1, value_end); }
+                        else if (memcmp(key, "part", 4) == 0)   { present |= param_part;    part    =   read_number(separator + 1, value_end); }
+                        break;
+                    case 5:
+                        if (memcmp(key, "total", 5) == 0)       { present |= param_total;   total   =   read_number(separator + 1, value_end); }
+                        else if (memcmp(key, "begin", 5) == 0)  { present |= param_begin;   begin   =   read_number(separator + 1, value_end); }
+                        else if (memcmp(key, "crc32", 5) == 0)  { present |= param_crc32;   crc32   =   read_hex(separator + 1, value_end); }
+                        break;
+                    case 6:
+                        if (memcmp(key, "pcrc32", 6) == 0)      { present |= param_pcrc32;  pcrc32  =   read_hex(separator + 1, value_end); }
+                        break;
+                }
+
+                // on to the next parameter
+                key =   value_end;
+            }
+
+            return true;
+        }
+    }
+}
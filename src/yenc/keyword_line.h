@@ -0,0 +1,89 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef YENC_KEYWORD_LINE_H
+#define YENC_KEYWORD_LINE_H 1
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace nntp
+{
+    namespace yenc
+    {
+        /**
+          * Parameters found on a keyword line
+          */
+        enum keyword_param
+        {
+            param_line      =   1 << 0,
+            param_size      =   1 << 1,
+            param_part      =   1 << 2,
+            param_total     =   1 << 3,
+            param_begin     =   1 << 4,
+            param_end       =   1 << 5,
+            param_name      =   1 << 6,
+            param_crc32     =   1 << 7,
+            param_pcrc32    =   1 << 8
+        };
+
+        /**
+          * @struct nntp::yenc::keyword_line
+          *
+          * The parameters of a =ybegin, =ypart or =yend line. The line is parsed in a single
+          * pass without copying: the name points into the parsed line, which therefore has to
+          * outlive the structure.
+          */
+        struct keyword_line
+        {
+            unsigned    present;        // which parameters were found, see keyword_param
+            long        line;           // line length used by the encoder
+            long        size;           // size of the file, or of the part on a =yend line
+            long        part;           // part number
+            long        total;          // total number of parts
+            long        begin;          // first byte of the part, starting at 1
+            long        end;            // last byte of the part
+            uint32_t    crc32;          // checksum of the whole file
+            uint32_t    pcrc32;         // checksum of the part
+            const char  *name;          // original filename, may contain spaces
+            std::size_t name_length;    // length of the filename
+
+            /**
+              * Parse a keyword line
+              *
+              * @param  keyword     the keyword the line should start with, e.g. "=ybegin"
+              * @param  line_begin  first character of the line
+              * @param  line_end    end of the line, a trailing line break is ignored
+              * @return whether the line starts with the keyword
+              */
+            bool parse(const char *keyword, const char *line_begin, const char *line_end);
+
+            /**
+              * Was a parameter present on the line?
+              *
+              * @param  param   the parameter to check for
+              * @return whether the parameter was found
+              */
+            bool has(keyword_param param) const
+            {
+                return (present & param) != 0;
+            }
+        };
+    }
+}
+
+#endif /* YENC_KEYWORD_LINE_H */
@@ -0,0 +1,208 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#include <algorithm>
+#include "stream_decoder.h"
+#include "keyword_line.h"
+
+namespace nntp
+{
+    namespace yenc
+    {
+        // longest keyword line we are willing to buffer
+        static const std::size_t max_line_length = 1024;
+
+        // constructor
+        stream_decoder::stream_decoder()
+        {
+            // start out empty
+            reset();
+        }
+
+        // start over with a new article
+        void stream_decoder::reset()
+        {
+            current     =   phase_header;
+            state       =   state_line_start;
+            expected    =   0;
+            written     =   0;
+            checksum    =   0;
+            info        =   NULL;
+
+            line.clear();
+            header.clear();
+        }
+
+        // collect characters for the current keyword line
+        bool stream_decoder::collect_line(const char *&data, const char *end)
+        {
+            const char  *line_end;  // pointer to the line feed
+            bool        complete;   // whether the line feed was found
+
+            // take everything up to and including the line feed
+            line_end    =   (const char *) memchr(data, '\n', end - data);
+            line_end    =   line_end == NULL ? end : line_end + 1;
+            complete    =   line_end[-1] == '\n';
+
+            line.append(data, line_end);
+            data        =   line_end;
+
+            if (line.size() > max_line_length)
+            {
+                // we do not buffer data, so a line this long cannot be a keyword line
+                if (current != phase_header || line.compare(0, 7, "=ybegin") == 0)
+                    throw decode_exception("Keyword line too long, is this really a yenc-encoded article");
+
+                // text in front of the header may be as long as it wants, it is skipped anyway
+                line.resize(max_line_length);
+            }
+
+            return complete;
+        }
+
+        // handle a completed keyword line
+        void stream_decoder::finish_line()
+        {
+            keyword_line    params; // parameters of the line
+
+            switch (current)
+            {
+                case phase_header:
+                    // skip anything in front of the header
+                    if (!params.parse("=ybegin", line.data(), line.data() + line.size()))
+                        break;
+
+                    header  =   line;
+
+                    // a multipart binary has a =ypart line too
+                    if (params.part != 0)
+                    {
+                        current =   phase_part;
+                        break;
+                    }
+
+                    // no =ypart line, start decoding
+                    info    =   new decoded_article(header.c_str(), header.size(), false);
+                    current =   phase_data;
+                    break;
+
+                case phase_part:
+                    // the header should be followed by a =ypart line
+                    if (!params.parse("=ypart", line.data(), line.data() + line.size()))
+                        throw decode_exception("Required ypart line not found");
+
+                    header  +=  line;
+
+                    // header complete, start decoding
+                    info    =   new decoded_article(header.c_str(), header.size(), false);
+                    current =   phase_data;
+                    break;
+
+                case phase_footer:
+                    // we should have the right amount of data by now
+                    if (written != expected)
+                        throw decode_exception("Not enough characters in input buffer");
+
+                    // let the article verify the data against the footer
+                    info->checksum      =   checksum;
+                    info->source_end    =   line.c_str() + line.size();
+                    info->parse_footer(line.c_str());
+
+                    current =   phase_done;
+                    break;
+
+                default:
+                    break;
+            }
+
+            // we know the size once the header is parsed
+            if (current == phase_data)
+                expected    =   info->decoded_size();
+
+            // start collecting the next line
+            line.clear();
+        }
+
+        // decode a chunk of the article
+        std::size_t stream_decoder::feed(const char *data, std::size_t length, char *target, std::size_t capacity)
+        {
+            const char  *end        =   data + length;  // end of the chunk
+            char        *begin      =   target;         // where we started writing
+            char        *previous;                      // where the last decode call started writing
+
+            // decoded data is never larger than encoded data
+            if (capacity < length)
+                throw decode_exception("Target buffer smaller than encoded data");
+
+            while (data < end)
+            {
+                switch (current)
+                {
+                    case phase_data:
+                        // never write more than the header announced
+                        previous    =   target;
+                        decode_crc(data, end, target, target + std::min(capacity - (target - begin), expected - written), state, checksum);
+                        written     +=  target - previous;
+
+                        // the keyword was consumed, put it back at the start of the footer line
+                        if (state == state_end)
+                        {
+                            line    =   "=y";
+                            current =   phase_footer;
+                        }
+                        // any data we could not write means there is too much of it
+                        else if (data != end)
+                            throw decode_exception("Too many characters in input buffer");
+
+                        break;
+
+                    case phase_done:
+                        // ignore anything after the footer
+                        data    =   end;
+                        break;
+
+                    default:
+                        // collect header and footer lines
+                        if (collect_line(data, end))
+                            finish_line();
+
+                        break;
+                }
+            }
+
+            return target - begin;
+        }
+
+        // have we seen the end of the article
+        bool stream_decoder::done()
+        {
+            return current == phase_done;
+        }
+
+        // get the header information
+        decoded_article_ptr stream_decoder::article()
+        {
+            return info;
+        }
+
+        // number of bytes decoded so far
+        std::size_t stream_decoder::decoded()
+        {
+            return written;
+        }
+    }
+}
@@ -0,0 +1,129 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef YENC_STREAM_DECODER_H
+#define YENC_STREAM_DECODER_H 1
+
+#include <string>
+#include "decoder.h"
+#include "decoded_article.h"
+
+namespace nntp
+{
+    namespace yenc
+    {
+        /**
+          * @class  nntp::yenc::stream_decoder
+          *
+          * Decodes an article while it is being received. Feed it the body in whatever chunks
+          * the socket returns them and it writes the decoded bytes as soon as they are complete.
+          * Only the keyword lines are buffered, so a decoder needs just a few hundred bytes no
+          * matter how large the article is.
+          */
+        class stream_decoder
+        {
+            private:
+                /**
+                  * Which part of the article we are in
+                  */
+                enum phase
+                {
+                    phase_header,   // looking for the =ybegin line
+                    phase_part,     // reading the =ypart line
+                    phase_data,     // decoding data
+                    phase_footer,   // reading the =yend line
+                    phase_done      // article is complete
+                };
+
+                phase               current;    // which part of the article we are in
+                decode_state        state;      // state of the data decoder
+                std::string         line;       // keyword line being collected
+                std::string         header;     // complete header lines
+                decoded_article_ptr info;       // the parsed header
+                std::size_t         expected;   // number of bytes the data should decode to
+                std::size_t         written;    // number of bytes decoded so far
+                uint32_t            checksum;   // crc32 of the data decoded so far
+
+                /**
+                  * Collect characters for the current keyword line
+                  *
+                  * @param  data    data to collect from, updated past the characters taken
+                  * @param  end     end of the data
+                  * @return whether the line is complete
+                  */
+                bool collect_line(const char *&data, const char *end);
+
+                /**
+                  * Handle a completed keyword line
+                  */
+                void finish_line();
+            public:
+                /**
+                  * Constructor
+                  */
+                stream_decoder();
+
+                /**
+                  * Start over with a new article
+                  */
+                void reset();
+
+                /**
+                  * Decode a chunk of the article
+                  *
+                  * @note   Decoded data is never larger than the encoded data, so a buffer
+                  *         of length bytes is always large enough.
+                  *
+                  * @throws decode_exception
+                  *
+                  * @param  data        chunk of the article body
+                  * @param  length      size of the chunk
+                  * @param  target      buffer to write decoded data to
+                  * @param  capacity    size of the buffer, at least length
+                  * @return the number of bytes written to the target
+                  */
+                std::size_t feed(const char *data, std::size_t length, char *target, std::size_t capacity);
+
+                /**
+                  * Have we seen the end of the article?
+                  *
+                  * @note   Once done, article()->check() tells whether the data was valid
+                  *
+                  * @return whether the =yend line was read
+                  */
+                bool done();
+
+                /**
+                  * Get the header information: filename, part number and position
+                  *
+                  * @note   NULL until the header lines have been received
+                  *
+                  * @return the article, without any data
+                  */
+                decoded_article_ptr article();
+
+                /**
+                  * How many bytes have been decoded so far?
+                  *
+                  * @return the number of bytes decoded
+                  */
+                std::size_t decoded();
+        };
+    }
+}
+
+#endif /* YENC_STREAM_DECODER_H */
@@ -0,0 +1,150 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#include <cstdio>
+#include "stream_encoder.h"
+#include "exceptions.h"
+
+namespace nntp
+{
+    namespace yenc
+    {
+        // encode a single part binary
+        stream_encoder::stream_encoder(const std::string& name, long size, int line_length) :
+            name(name),
+            size(size),
+            part(0),
+            total(0),
+            begin(1),
+            end(size),
+            line_length(line_length),
+            column(0),
+            written(0),
+            checksum(0),
+            file_checksum(0),
+            has_file_crc(false)
+        {}
+
+        // encode a part of a multipart binary
+        stream_encoder::stream_encoder(const std::string& name, long size, long part, long total, long begin, long end, int line_length) :
+            name(name),
+            size(size),
+            part(part),
+            total(total),
+            begin(begin),
+            end(end),
+            line_length(line_length),
+            column(0),
+            written(0),
+            checksum(0),
+            file_checksum(0),
+            has_file_crc(false)
+        {}
+
+        // set the checksum of the whole file
+        void stream_encoder::file_crc(uint32_t crc)
+        {
+            file_checksum   =   crc;
+            has_file_crc    =   true;
+        }
+
+        // number of bytes in this part
+        long stream_encoder::part_size()
+        {
+            return end - begin + 1;
+        }
+
+        // offset of the first byte of this part
+        long stream_encoder::part_offset()
+        {
+            return begin - 1;
+        }
+
+        // buffer size needed to encode a chunk
+        std::size_t stream_encoder::encoded_size(std::size_t length)
+        {
+            return max_encoded_size(length, line_length);
+        }
+
+        // write the =ybegin and =ypart lines
+        std::string stream_encoder::header()
+        {
+            char    line[128];  // buffer for the numeric parameters
+
+            // a single part binary only has the =ybegin line
+            if (part == 0)
+            {
+                sprintf(line, "=ybegin line=%d size=%ld name=", line_length, size);
+                return line + name + "\r\n";
+            }
+
+            sprintf(line, "=ybegin part=%ld total=%ld line=%d size=%ld name=", part, total, line_length, size);
+
+            std::string result  =   line + name + "\r\n";
+
+            sprintf(line, "=ypart begin=%ld end=%ld\r\n", begin, end);
+
+            return result + line;
+        }
+
+        // encode a chunk of the data
+        std::size_t stream_encoder::feed(const char *data, std::size_t length, char *target, std::size_t capacity)
+        {
+            const char  *data_end   =   data + length;  // end of the chunk
+            char        *start      =   target;         // where we started writing
+
+            // the whole chunk has to fit
+            if (capacity < encoded_size(length))
+                throw decode_exception("Target buffer too small for encoded data");
+
+            encode_crc(data, data_end, target, target + capacity, column, line_length, checksum);
+            written +=  length;
+
+            return target - start;
+        }
+
+        // close the last line and write the =yend line
+        std::string stream_encoder::footer()
+        {
+            char    line[128];  // buffer for the footer
+
+            // the header promised an exact amount of data
+            if (written != part_size())
+                throw decode_exception("Encoded data does not match the part size");
+
+            // the last line may not be complete yet
+            std::string result  =   column > 0 ? "\r\n" : "";
+
+            if (part == 0)
+                sprintf(line, "=yend size=%ld crc32=%08x\r\n", written, checksum);
+            else if (has_file_crc)
+                sprintf(line, "=yend size=%ld part=%ld pcrc32=%08x crc32=%08x\r\n", written, part, checksum, file_checksum);
+            else
+                sprintf(line, "=yend size=%ld part=%ld pcrc32=%08x\r\n", written, part, checksum);
+
+            column  =   0;
+
+            return result + line;
+        }
+
+        // checksum of the data encoded so far
+        uint32_t stream_encoder::crc()
+        {
+            return checksum;
+        }
+    }
+}
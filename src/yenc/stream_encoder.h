@@ -0,0 +1,142 @@
+/**
+  * This file is part of libnntp.
+  *
+  * libnntp is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * libnntp is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with libnntp. If not, see <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef YENC_STREAM_ENCODER_H
+#define YENC_STREAM_ENCODER_H 1
+
+#include <string>
+#include <stdint.h>
+#include "encoder.h"
+
+namespace nntp
+{
+    namespace yenc
+    {
+        /**
+          * @class  nntp::yenc::stream_encoder
+          *
+          * Encodes a file, or a part of one, while it is being sent: the counterpart of the
+          * stream_decoder. Write the header(), feed() the data in chunks of any size and
+          * finish with the footer(), which carries the checksum computed along the way.
+          */
+        class stream_encoder
+        {
+            private:
+                std::string name;       // original filename
+                long        size;       // total size of the file
+                long        part;       // part number, 0 for a single part binary
+                long        total;      // total number of parts
+                long        begin;      // first byte of the part, starting at 1
+                long        end;        // last byte of the part
+                int         line_length;// number of characters per line
+                int         column;     // column of the current line
+                long        written;    // number of bytes encoded so far
+                uint32_t    checksum;   // crc32 of the bytes encoded so far
+                uint32_t    file_checksum;  // crc32 of the whole file, if known
+                bool        has_file_crc;   // whether the whole file checksum is known
+            public:
+                /**
+                  * Encode a single part binary
+                  *
+                  * @param  name        original filename
+                  * @param  size        size of the file
+                  * @param  line_length number of characters per line
+                  */
+                stream_encoder(const std::string& name, long size, int line_length = 128);
+
+                /**
+                  * Encode a part of a multipart binary
+                  *
+                  * @param  name        original filename
+                  * @param  size        size of the whole file
+                  * @param  part        part number, starting at 1
+                  * @param  total       total number of parts
+                  * @param  begin       first byte of the part, starting at 1
+                  * @param  end         last byte of the part
+                  * @param  line_length number of characters per line
+                  */
+                stream_encoder(const std::string& name, long size, long part, long total, long begin, long end, int line_length = 128);
+
+                /**
+                  * Set the checksum of the whole file, which is then added to the footer
+                  *
+                  * @param  crc     crc32 of the whole file
+                  */
+                void file_crc(uint32_t crc);
+
+                /**
+                  * Get the number of bytes this part holds
+                  *
+                  * @return the size of the part
+                  */
+                long part_size();
+
+                /**
+                  * Get the offset in the file where this part starts
+                  *
+                  * @return the offset of the first byte, starting at 0
+                  */
+                long part_offset();
+
+                /**
+                  * Get the buffer size needed to encode a chunk
+                  *
+                  * @param  length  size of the chunk
+                  * @return the maximum number of characters feed() writes
+                  */
+                std::size_t encoded_size(std::size_t length);
+
+                /**
+                  * Write the =ybegin and =ypart lines
+                  *
+                  * @return the header lines
+                  */
+                std::string header();
+
+                /**
+                  * Encode a chunk of the data
+                  *
+                  * @note   The checksum is computed in the same pass
+                  *
+                  * @param  data        chunk of the data
+                  * @param  length      size of the chunk
+                  * @param  target      buffer to write the encoded chunk to
+                  * @param  capacity    size of the buffer, at least encoded_size(length)
+                  * @return the number of characters written
+                  */
+                std::size_t feed(const char *data, std::size_t length, char *target, std::size_t capacity);
+
+                /**
+                  * Close the last line and write the =yend line
+                  *
+                  * @throws decode_exception when less or more data was fed than the part holds
+                  *
+                  * @return the footer
+                  */
+                std::string footer();
+
+                /**
+                  * Get the checksum of the data encoded so far
+                  *
+                  * @return the crc32 of the data
+                  */
+                uint32_t crc();
+        };
+    }
+}
+
+#endif /* YENC_STREAM_ENCODER_H */